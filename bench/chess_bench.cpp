@@ -0,0 +1,282 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "fen.h"
+#include "move.h"
+#include "position_batch.h"
+#include "raylib.h"
+#include "render.h"
+
+// Fixed corpus so runs can be compared, openings, middlegames and endings
+const std::vector<std::string> CORPUS = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w - - 0 1",
+    "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w - - 2 3",
+    "r2q1rk1/pp2bppp/2n1bn2/3p4/3P4/2NBBN2/PP3PPP/R2Q1RK1 w - - 0 11",
+    "r1b2rk1/2q1bppp/p2ppn2/1p6/3BPP2/2N2B2/PPPQ2PP/R4R1K w - - 0 15",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w - - 0 1",
+    "4r1k1/5ppp/8/8/8/8/5PPP/R5K1 b - - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "8/8/8/4k3/8/8/8/KQ6 w - - 0 1",
+};
+
+typedef struct Board {
+    std::array<std::array<int, 8>, 8> pieces;
+    int color;
+} Board;
+
+typedef struct BenchResult {
+    std::string name;
+    size_t ops;
+    double ns_per_op;  // median of the samples
+    double ns_per_op_min;
+} BenchResult;
+
+// keeps the compiler from throwing the work away, printed at the end
+size_t sink = 0;
+
+// Runs f (which does ops_per_call operations) in samples of about 20 ms and keeps the median
+template <typename F>
+BenchResult run_benchmark(std::string name, size_t ops_per_call, F f) {
+    using clock = std::chrono::steady_clock;
+
+    size_t calls = 1;
+    while (true) {
+        auto start = clock::now();
+        for (size_t i = 0; i < calls; i++) {
+            f();
+        }
+        if (clock::now() - start > std::chrono::milliseconds(20) || calls > ((size_t)1 << 30)) {
+            break;
+        }
+        calls *= 2;
+    }
+
+    std::vector<double> samples;
+    for (int sample = 0; sample < 7; sample++) {
+        auto start = clock::now();
+        for (size_t i = 0; i < calls; i++) {
+            f();
+        }
+        double ns = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+        samples.push_back(ns / (calls * ops_per_call));
+    }
+    std::sort(samples.begin(), samples.end());
+
+    BenchResult result = {name, calls * ops_per_call, samples[samples.size() / 2], samples[0]};
+    std::cerr << std::format("{:<32} {:>12.1f} ns/op\n", result.name, result.ns_per_op);
+    return result;
+}
+
+std::vector<Position> pieces_of_type(Board *board, int type) {
+    std::vector<Position> result;
+    for (int x = 0; x < 8; x++) {
+        for (int y = 0; y < 8; y++) {
+            if (board->pieces[x][y] && (type == Piece::None || piece_type(board->pieces[x][y]) == type)) {
+                result.push_back({x, y});
+            }
+        }
+    }
+    return result;
+}
+
+void bench_rules(std::vector<Board> *corpus, std::vector<BenchResult> *results) {
+    std::vector<std::tuple<std::string, int>> types = {
+        {"pawn", Piece::Pawn},
+        {"knight", Piece::Knight},
+        {"bishop", Piece::Bishop},
+        {"rook", Piece::Rook},
+        {"queen", Piece::Queen},
+        {"king", Piece::King},
+    };
+
+    // Pseudo legal generation, per piece
+    for (auto &[type_name, type] : types) {
+        std::vector<std::tuple<Board *, Position>> targets;
+        for (auto &board : (*corpus)) {
+            for (auto &position : pieces_of_type(&board, type)) {
+                targets.push_back({&board, position});
+            }
+        }
+        results->push_back(run_benchmark("primative_positions/" + type_name, targets.size(), [&]() {
+            for (auto &[board, position] : targets) {
+                sink += get_primative_positions(&board->pieces, position.x, position.y).size();
+            }
+        }));
+    }
+
+    // Sliding pieces only
+    std::vector<std::tuple<Board *, Position, std::vector<Direction>>> sliders;
+    for (auto &board : (*corpus)) {
+        for (auto &position : pieces_of_type(&board, Piece::None)) {
+            int type = piece_type(board.pieces[position.x][position.y]);
+            if (type == Piece::Bishop) {
+                sliders.push_back({&board, position, Directions::Bishop});
+            } else if (type == Piece::Rook) {
+                sliders.push_back({&board, position, Directions::Rook});
+            } else if (type == Piece::Queen) {
+                sliders.push_back({&board, position, Directions::Queen});
+            }
+        }
+    }
+    results->push_back(run_benchmark("positions_in_directions", sliders.size(), [&]() {
+        for (auto &[board, position, directions] : sliders) {
+            sink += get_positions_in_directions(&board->pieces, position, directions).size();
+        }
+    }));
+
+    // Legality filtering, per piece of the side to move
+    std::vector<std::tuple<Board *, Position>> movers;
+    for (auto &board : (*corpus)) {
+        for (auto &position : pieces_of_type(&board, Piece::None)) {
+            if (piece_color(board.pieces[position.x][position.y]) == board.color) {
+                movers.push_back({&board, position});
+            }
+        }
+    }
+    results->push_back(run_benchmark("legal_positions", movers.size(), [&]() {
+        for (auto &[board, position] : movers) {
+            sink += get_legal_positions(&board->pieces, position.x, position.y).size();
+        }
+    }));
+    results->push_back(run_benchmark("valid_positions", movers.size(), [&]() {
+        for (auto &[board, position] : movers) {
+            player.number_of_moves = (board->color == Piece::White) ? 0 : 1;
+            sink += get_valid_positions(&board->pieces, position.x, position.y).size();
+        }
+    }));
+
+    // Whole positions
+    results->push_back(run_benchmark("legal_moves", corpus->size(), [&]() {
+        for (auto &board : (*corpus)) {
+            sink += get_legal_moves(&board.pieces, board.color).size();
+        }
+    }));
+    results->push_back(run_benchmark("is_under_attack", corpus->size() * 2, [&]() {
+        for (auto &board : (*corpus)) {
+            sink += is_under_attack(Piece::White, &board.pieces);
+            sink += is_under_attack(Piece::Black, &board.pieces);
+        }
+    }));
+
+    // Same questions through the batch kernels, the corpus repeated to fill a few blocks
+    PositionBatch batch;
+    for (int i = 0; i < 64; i++) {
+        for (auto &board : (*corpus)) {
+            batch.add(&board.pieces, board.color);
+        }
+    }
+    std::vector<uint8_t> checks;
+    std::vector<uint16_t> counts;
+    results->push_back(run_benchmark("batch/in_check", batch.size(), [&]() {
+        batch.in_check(&checks);
+        sink += checks[0];
+    }));
+    results->push_back(run_benchmark("batch/legal_move_count", batch.size(), [&]() {
+        batch.legal_move_count(&counts);
+        sink += counts[0];
+    }));
+    results->push_back(run_benchmark("batch/is_mate", batch.size(), [&]() {
+        batch.is_mate(&checks);
+        sink += checks[0];
+    }));
+
+    // State setup
+    results->push_back(run_benchmark("init_pieces", 1, [&]() {
+        auto pieces = init_pieces(player.color);
+        auto squares = init_squares();
+        sink += pieces[0][0] + squares[0][0];
+    }));
+}
+
+// Frame cost, drawn into a texture in a hidden window
+void bench_render(std::vector<Board> *corpus, std::vector<BenchResult> *results) {
+    int length = Constants::SQUARE_LENGTH * 8;
+    SetTraceLogLevel(LOG_WARNING);
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    InitWindow(length, length, "chess_bench");
+    if (!IsWindowReady()) {
+        std::cerr << "no window, skipping the render benchmarks\n";
+        return;
+    }
+
+    RenderTexture2D target = LoadRenderTexture(length, length);
+    auto start_pieces = init_pieces(player.color);
+    auto piece_textures = load_textures(&start_pieces);
+    auto squares = init_squares();
+
+    results->push_back(run_benchmark("draw_squares", 1, [&]() {
+        BeginTextureMode(target);
+        draw_squares(&squares);
+        EndTextureMode();
+    }));
+    results->push_back(run_benchmark("draw_pieces", corpus->size(), [&]() {
+        BeginTextureMode(target);
+        for (auto &board : (*corpus)) {
+            draw_pieces(&board.pieces, &piece_textures);
+        }
+        EndTextureMode();
+    }));
+
+    unload_textures(&piece_textures);
+    UnloadRenderTexture(target);
+    CloseWindow();
+}
+
+std::string to_json(std::vector<BenchResult> *results) {
+    std::string json = "{\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results->size(); i++) {
+        auto &result = (*results)[i];
+        json += std::format("    {{\"name\": \"{}\", \"ops\": {}, \"ns_per_op\": {:.2f}, \"ns_per_op_min\": {:.2f}}}", result.name, result.ops, result.ns_per_op, result.ns_per_op_min);
+        json += (i + 1 < results->size()) ? ",\n" : "\n";
+    }
+    json += "  ]\n}\n";
+    return json;
+}
+
+int main(int argc, char **argv) {
+    bool render = true;
+    std::string json_path;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--no-render") {
+            render = false;
+        } else if (arg == "--json" && i + 1 < argc) {
+            json_path = argv[++i];
+        } else {
+            std::cerr << "usage: chess_bench [--no-render] [--json out.json]\n";
+            return 1;
+        }
+    }
+
+    std::vector<Board> corpus;
+    for (auto &fen : CORPUS) {
+        Board board;
+        if (!board_from_fen(fen, &board.pieces, &board.color)) {
+            std::cerr << std::format("bad fen in corpus {}\n", fen);
+            return 1;
+        }
+        corpus.push_back(board);
+    }
+
+    std::vector<BenchResult> results;
+    bench_rules(&corpus, &results);
+    if (render) {
+        bench_render(&corpus, &results);
+    }
+
+    // JSON goes to stdout unless a file is given, the table above went to stderr
+    std::cerr << std::format("checksum {}\n", sink);
+    std::string json = to_json(&results);
+    if (json_path.empty()) {
+        std::cout << json;
+    } else {
+        std::ofstream(json_path) << json;
+    }
+    return 0;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Win/draw/loss bitbases for small endings, made by retrograde analysis with our own move rules.
+//
+// A material set is written like "KPK" or "KRKP": the first side's king and pieces, then the
+// other side's. Tables always have the first side as white; probing a position where black
+// has that material mirrors the board.
+//
+// A table holds 2 bits per position (Wdl::, from the side to move's point of view), indexed by
+//   side to move (white = 0) * 64^n + square of piece 0 * 64^(n-1) + ... + square of piece n-1
+// with squares numbered a1 = 0 ... h8 = 63 and pieces in the order of the material string.
+struct Wdl {
+    static const int Unknown = -1;  // no table for this material
+    static const int Draw = 0;
+    static const int Win = 1;
+    static const int Loss = 2;
+};
+
+// "KRKP" style name for a position's material, white first
+std::string material_name(std::array<std::array<int, 8>, 8> *pieces);
+size_t bitbase_size(std::string material);
+
+// Retrograde analysis, every table for a smaller material set reachable by a capture must be registered first
+bool generate_bitbase(std::string material, std::vector<unsigned char> *table, int thread_count);
+
+// data must outlive every probe (embedded tables, or load_bitbase_file which keeps it mapped)
+void register_bitbase(std::string material, const unsigned char *data, size_t size);
+bool load_bitbase_file(std::string material, std::string path);
+// Registers the tables compiled into the binary (KRK, KQK)
+void load_embedded_bitbases();
+
+int probe_bitbase(std::array<std::array<int, 8>, 8> *pieces, int color_to_move);
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+typedef struct Position {
+    int x;
+    int y;
+} Position;
+inline bool operator==(const Position &lhs, const Position &rhs) { return (lhs.x == rhs.x) && (lhs.y == rhs.y); }
+
+// namespace Moves {
+//     inline const std::array<int, 2> Queen = {2, 2};
+// }
+
+enum class Direction { North, East, South, West, NorthEast, SouthEast, SouthWest, NorthWest };
+
+namespace Directions {
+    inline std::vector<Direction> Queen = {Direction::North, Direction::East, Direction::South, Direction::West, Direction::NorthEast, Direction::SouthEast, Direction::SouthWest, Direction::NorthWest};
+    inline std::vector<Direction> Bishop = {Direction::NorthEast, Direction::SouthEast, Direction::SouthWest, Direction::NorthWest};
+    inline std::vector<Direction> Rook = {Direction::North, Direction::East, Direction::South, Direction::West};
+}  // namespace Directions
+
+struct Piece {
+    static const int None = 0b00000;    // 0
+    static const int Pawn = 0b00001;    // 1
+    static const int Knight = 0b00011;  // 2
+    static const int Bishop = 0b00100;  // 3
+    static const int Rook = 0b00101;    // 4
+    static const int Queen = 0b00110;   // 5
+    static const int King = 0b00111;    // 6
+
+    static const int Black = 0b01000;  // 8
+    static const int White = 0b10000;  // 16
+};
+
+class Player {
+   public:
+    const int color;
+    int homeColumn;
+    int number_of_moves;
+    Player(int clr) : color(clr) {
+        if (clr == Piece::Black) {
+            homeColumn = 1;
+        } else {
+            homeColumn = 6;
+        }
+    };
+};
+
+extern Player player;
+
+int piece_type(int a);
+int piece_color(int a);
+int opposite_color(int color);
+int forward(int color, int col, int dcol);
+
+std::vector<Position> get_positions_in_directions(std::array<std::array<int, 8>, 8> *pieces, Position starting_position, std::vector<Direction> directions);
+bool position_is_within_board(Position position);
+bool is_valid_primative_move(std::array<std::array<int, 8>, 8> *pieces, Position start_pos, Position end_pos);
+std::vector<Position> get_primative_knight_positions(std::array<std::array<int, 8>, 8> *pieces, int x, int y);
+std::vector<Position> get_primative_king_positions(std::array<std::array<int, 8>, 8> *pieces, int x, int y);
+std::vector<Position> get_primative_pawn_positions(std::array<std::array<int, 8>, 8> *pieces, int x, int y);
+std::vector<Position> get_primative_positions(std::array<std::array<int, 8>, 8> *pieces, int x, int y);
+std::vector<Position> get_attacking_positions(std::array<std::array<int, 8>, 8> *pieces, int x, int y);
+std::vector<Position> get_all_attacking_positions(int color, std::array<std::array<int, 8>, 8> *pieces);
+bool is_under_attack(int color, std::array<std::array<int, 8>, 8> *pieces);
+void move_piece(std::array<std::array<int, 8>, 8> *pieces, Position initial, Position final);
+std::vector<Position> get_legal_positions(std::array<std::array<int, 8>, 8> *pieces, int x, int y);
+int side_to_move(int number_of_moves);
+std::vector<Position> get_valid_positions(std::array<std::array<int, 8>, 8> *pieces, int x, int y);
+
+std::array<std::array<int, 8>, 8> init_pieces(int color);
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mapped_file.h"
+#include "move.h"
+
+// Polyglot opening book (.bin)
+//
+// A file of 16 byte big endian entries sorted by key:
+//   u64 key   hash_position() of the position
+//   u16 move  same layout as Move
+//   u16 weight
+//   u32 learn (unused)
+//
+// Books from other programs can have castling moves, written as the king taking its own rook (e1h1).
+// The rules have no castling, so check moves with is_legal_move before using them.
+typedef struct BookEntry {
+    uint64_t key;
+    Move move;
+    uint16_t weight;
+    uint32_t learn;
+} BookEntry;
+
+namespace BookFile {
+    inline const size_t ENTRY_SIZE = 16;
+}  // namespace BookFile
+
+class Book {
+   public:
+    // The file is memory mapped, nothing is read until a position is looked up
+    Book(std::string path);
+
+    bool is_open() { return file.is_open(); }
+    size_t entry_count() { return file.size() / BookFile::ENTRY_SIZE; }
+    // Every move for the position, most played first
+    std::vector<BookEntry> find(uint64_t key);
+    // Picks one of the moves for the position with probability proportional to its weight,
+    // random is any uniformly distributed number
+    bool pick(uint64_t key, uint64_t random, Move *move);
+
+   private:
+    MappedFile file;
+    BookEntry entry(size_t i);
+};
+
+// Sorts entries and writes them as a book, weights must already fit in 16 bits
+bool write_book(std::vector<BookEntry> *entries, std::string path);
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <array>
+#include <string>
+
+#include "board.h"
+
+// Forsyth-Edwards Notation. Only the placement and the side to move mean anything to our
+// rules, castling and en passant fields are ignored when reading and written as "-".
+bool board_from_fen(std::string fen, std::array<std::array<int, 8>, 8> *pieces, int *color_to_move);
+std::string fen_from_board(std::array<std::array<int, 8>, 8> *pieces, int color_to_move);
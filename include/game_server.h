@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "packed_board.h"
+
+struct GameStatus {
+    static const int Free = 0;
+    static const int Playing = 1;
+    static const int WhiteWins = 2;
+    static const int BlackWins = 3;
+    static const int Stalemate = 4;
+};
+
+// Everything the server keeps about one game
+typedef struct GameState {
+    PackedBoard board;
+    uint32_t generation;  // bumped when the slot is reused, so ids of ended games stop working
+    uint16_t ply;         // white moves on even plies, like player.number_of_moves
+    uint8_t status;
+    uint8_t reserved;
+} GameState;
+static_assert(sizeof(GameState) == 40);
+
+namespace GameServerLimits {
+    inline const uint32_t GAMES_PER_SLAB = 4096;
+    // game id = generation << 32 | slot << SHARD_BITS | shard
+    inline const int SHARD_BITS = 8;
+    inline const int MAX_SHARDS = 1 << SHARD_BITS;
+    inline const size_t MAX_LINE = 4096;
+    // per connection. Input past this is left in the socket until earlier lines are answered,
+    // clients that let more answers than this pile up without reading them are disconnected
+    inline const size_t MAX_BUFFERED = 64 * 1024;
+}  // namespace GameServerLimits
+
+// Games in fixed size blocks that never move once allocated. Ended games go on a free list
+// and their slots are handed out again before a new block is made.
+class GameSlab {
+   public:
+    uint32_t allocate();
+    void release(uint32_t slot);
+
+    bool contains(uint32_t slot) { return slot < capacity; }
+    GameState *at(uint32_t slot) { return &slabs[slot / GameServerLimits::GAMES_PER_SLAB][slot % GameServerLimits::GAMES_PER_SLAB]; }
+    size_t live() { return capacity - free_slots.size(); }
+
+   private:
+    std::vector<std::unique_ptr<GameState[]>> slabs;
+    std::vector<uint32_t> free_slots;
+    uint32_t capacity = 0;
+};
+
+// One worker thread and the games it owns. Only that thread touches the slab, so games need no locks.
+//
+// Commands, one per line, each answered with one "ok ..." or "error ..." line:
+//   new [fen]          ok <id>
+//   move <id> <e2e4>   ok <status>
+//   moves <id>         ok <move> <move> ...
+//   status <id>        ok <status> <fen>
+//   end <id>           ok
+class GameShard {
+   public:
+    GameShard(int index) : index(index) {}
+
+    // Runs a command against this shard's games, used by the worker thread
+    std::string handle(std::string line);
+
+   private:
+    friend class GameServer;
+
+    int index;
+    GameSlab slab;
+
+    GameState *find(uint64_t id);
+
+    // owned by the server, requests are the only thing shared with the epoll thread
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<std::tuple<int, uint64_t, std::string>> requests;  // fd, connection serial, line
+};
+
+const char *game_status_name(int status);
+
+// Headless referee for many games at once. One thread runs an epoll loop over a unix domain
+// socket and hands each line to the shard that owns the game, the shards answer through an eventfd.
+// A connection has at most one command in flight so its answers come back in order,
+// and isn't read from while it has one.
+class GameServer {
+   public:
+    GameServer(int threads);
+    ~GameServer();
+    GameServer(const GameServer &) = delete;
+    GameServer &operator=(const GameServer &) = delete;
+
+    bool listen(std::string path);
+    // Serves until stop() is called
+    void run();
+    void stop();
+
+   private:
+    typedef struct Connection {
+        uint64_t serial;
+        std::string in;
+        std::string out;
+        bool busy = false;
+        bool read_closed = false;  // got EOF, closes once every answer is sent
+    } Connection;
+
+    std::vector<std::unique_ptr<GameShard>> shards;
+    std::atomic<bool> stopping = false;
+    int listen_fd = -1;
+    int epoll_fd = -1;
+    int wake_fd = -1;
+    uint64_t next_serial = 1;
+    size_t next_shard = 0;
+    std::unordered_map<int, Connection> connections;
+
+    std::mutex answers_mutex;
+    std::vector<std::tuple<int, uint64_t, std::string>> answers;  // fd, connection serial, line
+
+    void work(GameShard *shard);
+    void accept_connections();
+    void read_connection(int fd);
+    void dispatch(int fd);
+    void flush(int fd);
+    void close_connection(int fd);
+    void collect_answers();
+};
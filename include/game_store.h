@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "mapped_file.h"
+#include "move.h"
+
+// Binary game store
+//
+//   file header   "CHGS" + u32 version
+//   per game      GameHeader followed by ply_count 16 bit moves
+//
+// Games are only ever appended, a game's id is its position in the file.
+// Everything is little endian.
+namespace GameStore {
+    inline const char MAGIC[4] = {'C', 'H', 'G', 'S'};
+    inline const uint32_t VERSION = 1;
+    inline const size_t FILE_HEADER_SIZE = 8;
+}  // namespace GameStore
+
+typedef struct GameHeader {
+    uint16_t ply_count;
+    uint8_t result;  // Result::
+    uint8_t flags;   // reserved
+    uint16_t white_elo;
+    uint16_t black_elo;
+    uint32_t date;  // yyyymmdd
+} GameHeader;
+static_assert(sizeof(GameHeader) == 12);
+
+class GameWriter {
+   public:
+    // Opens path for appending, writing the file header if the file is new
+    GameWriter(std::string path);
+    ~GameWriter();
+    GameWriter(const GameWriter &) = delete;
+    GameWriter &operator=(const GameWriter &) = delete;
+
+    bool is_open() { return file != nullptr; }
+    bool append(GameHeader header, std::vector<Move> *moves);
+
+   private:
+    FILE *file = nullptr;
+};
+
+class GameReader {
+   public:
+    GameReader(std::string path);
+
+    bool is_open() { return valid; }
+    size_t game_count() { return offsets.size(); }
+    GameHeader header(uint32_t game_id);
+    std::span<const Move> moves(uint32_t game_id);
+
+   private:
+    MappedFile file;
+    std::vector<uint64_t> offsets;  // of every GameHeader
+    bool valid = false;
+};
+
+// Position index
+//
+//   file header   "CHPI" + u32 version + u64 entry count
+//   entries       PositionIndexEntry, sorted by (key, game_id, ply)
+//
+// key is the zobrist hash of the position after ply moves of game game_id,
+// so finding every game that reaches a position is a binary search.
+namespace PositionIndexFile {
+    inline const char MAGIC[4] = {'C', 'H', 'P', 'I'};
+    inline const uint32_t VERSION = 1;
+    inline const size_t FILE_HEADER_SIZE = 16;
+}  // namespace PositionIndexFile
+
+typedef struct PositionIndexEntry {
+    uint64_t key;
+    uint32_t game_id;
+    uint16_t ply;
+    uint16_t reserved;
+} PositionIndexEntry;
+static_assert(sizeof(PositionIndexEntry) == 16);
+
+// Replays every game on thread_count threads (0 = all cores) and writes the sorted index to path
+bool build_position_index(GameReader *games, std::string path, int thread_count);
+
+class PositionIndex {
+   public:
+    PositionIndex(std::string path);
+
+    bool is_open() { return valid; }
+    size_t entry_count() { return entries.size(); }
+    std::span<const PositionIndexEntry> find(uint64_t key);
+
+   private:
+    MappedFile file;
+    std::span<const PositionIndexEntry> entries;
+    bool valid = false;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "move.h"
+
+// Every move played in a game, with side variations.
+//
+// Nodes hold the move that led to them and what it captured, which is all it takes to undo it,
+// so moving around the tree touches two squares per ply and never copies a board.
+// Nodes live in one vector and link to each other by index; they're never freed.
+typedef struct GameNode {
+    Move move;         // move that led here, 0 for the root
+    uint8_t captured;  // piece the move took, Piece::None if nothing
+    uint8_t reserved;
+    uint32_t parent;
+    uint32_t first_child;     // the first move played from here is the main line
+    uint32_t next_sibling;    // other moves played from the parent
+    uint32_t selected_child;  // where forward() goes, the last child we came back from
+} GameNode;
+
+namespace GameTreeNode {
+    inline const uint32_t NONE = UINT32_MAX;
+    inline const uint32_t ROOT = 0;
+}  // namespace GameTreeNode
+
+class GameTree {
+   public:
+    GameTree();
+
+    uint32_t current() { return node; }
+    int ply() { return depth; }
+    GameNode *at(uint32_t index) { return &nodes[index]; }
+
+    // Plays move on pieces, going into the existing child if this move was played here before
+    void play(std::array<std::array<int, 8>, 8> *pieces, Move move);
+
+    // Each of these updates pieces and returns false if there's nowhere to go
+    bool back(std::array<std::array<int, 8>, 8> *pieces);
+    bool forward(std::array<std::array<int, 8>, 8> *pieces);
+    // swaps the last move for the next or previous move played from the same position
+    bool next_variation(std::array<std::array<int, 8>, 8> *pieces);
+    bool previous_variation(std::array<std::array<int, 8>, 8> *pieces);
+    // along the current line, forward goes as far as the selected children go
+    void jump_to_ply(std::array<std::array<int, 8>, 8> *pieces, int target);
+    void jump_to_node(std::array<std::array<int, 8>, 8> *pieces, uint32_t target);
+
+    // moves from the root to the current node
+    std::vector<Move> line();
+
+   private:
+    std::vector<GameNode> nodes;
+    uint32_t node = GameTreeNode::ROOT;
+    int depth = 0;
+
+    void enter(std::array<std::array<int, 8>, 8> *pieces, uint32_t child);
+};
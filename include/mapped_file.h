@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read only memory mapping of a whole file. The pages are shared with the
+// page cache, so opening a big file doesn't copy it onto the heap.
+class MappedFile {
+   public:
+    MappedFile(std::string path);
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool is_open() { return mapping != nullptr; }
+    const unsigned char *data() { return (const unsigned char *)mapping; }
+    size_t size() { return length; }
+
+   private:
+    void *mapping = nullptr;
+    size_t length = 0;
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include "move.h"
+
+// Proof-number search for forced mates. The side to move is the attacker, a mate in n
+// is proven when every defence is mated within 2n - 1 plies.
+struct MateStatus {
+    static const int Unknown = 0;    // ran out of nodes
+    static const int Proven = 1;     // line holds the shortest mate
+    static const int Disproven = 2;  // no mate in n
+};
+
+typedef struct MateResult {
+    int status = MateStatus::Unknown;
+    // the attacker's moves and the longest defence, ends with mate
+    std::vector<Move> line;
+    size_t nodes = 0;
+} MateResult;
+
+// Finds the shortest mate of at most mate_in moves.
+// cancel can be set from another thread to give up early, the result is then Unknown
+MateResult solve_mate(std::array<std::array<int, 8>, 8> *pieces, int color_to_move, int mate_in, size_t max_nodes, std::atomic<bool> *cancel = nullptr);
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "board.h"
+
+// A move packed into 16 bits, laid out the same way polyglot books do it:
+//   bits 0-5   to square
+//   bits 6-11  from square
+//   bits 12-14 promotion piece (always 0, the rules don't promote yet)
+// Squares are numbered a1 = 0 ... h8 = 63 no matter which color the player is.
+typedef uint16_t Move;
+
+int square_index(Position position);
+Position position_from_square_index(int square);
+
+Move encode_move(Position from, Position to);
+Position move_from(Move move);
+Position move_to(Move move);
+
+// Every legal move for color
+std::vector<Move> get_legal_moves(std::array<std::array<int, 8>, 8> *pieces, int color);
+// For moves from outside, like book moves
+bool is_legal_move(std::array<std::array<int, 8>, 8> *pieces, int color, Move move);
+bool has_legal_moves(std::array<std::array<int, 8>, 8> *pieces, int color);
+
+// "e2e4" style coordinate notation
+std::string move_to_string(Move move);
+bool move_from_string(std::string s, Move *move);
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "board.h"
+
+// A board in 32 bytes, 4 bits per square in the same x * 8 + y order as the board array.
+// Each nibble is white << 3 | piece_type, 0 for an empty square, like PackedPosition uses.
+typedef struct PackedBoard {
+    uint8_t squares[32];
+} PackedBoard;
+static_assert(sizeof(PackedBoard) == 32);
+
+inline int packed_nibble(int piece) {
+    if (!piece) {
+        return 0;
+    }
+    return ((piece_color(piece) == Piece::White) ? 0b1000 : 0) | piece_type(piece);
+}
+
+inline int piece_from_nibble(int nibble) {
+    if (!nibble) {
+        return Piece::None;
+    }
+    return ((nibble & 0b1000) ? Piece::White : Piece::Black) | (nibble & 0b0111);
+}
+
+PackedBoard pack_board(std::array<std::array<int, 8>, 8> *pieces);
+void unpack_board(PackedBoard *packed, std::array<std::array<int, 8>, 8> *pieces);
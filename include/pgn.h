@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "move.h"
+
+struct Result {
+    static const int Unknown = 0;    // *
+    static const int WhiteWins = 1;  // 1-0
+    static const int BlackWins = 2;  // 0-1
+    static const int Draw = 3;       // 1/2-1/2
+};
+
+struct PgnGame {
+    int result = Result::Unknown;
+    int white_elo = 0;
+    int black_elo = 0;
+    uint32_t date = 0;  // yyyymmdd, 0 when unknown
+    std::vector<Move> moves;
+    // false when a move couldn't be played with our rules (castling, en passant, promotion, bad SAN)
+    bool complete = true;
+};
+
+// Reads every game in a PGN file. Games are replayed from the starting position
+// and stop at the first move the rules can't play, see PgnGame::complete.
+std::vector<PgnGame> read_pgn(std::string text);
+
+// Finds the legal move for color that matches a standard algebraic notation move like "Nbd7"
+bool move_from_san(std::array<std::array<int, 8>, 8> *pieces, int color, std::string san, Move *move);
+// and the other way around, "Nbd7+"
+std::string move_to_san(std::array<std::array<int, 8>, 8> *pieces, Move move);
+// A line of moves played from pieces, "Ra6+ f6 Bxf6+"
+std::string line_to_san(std::array<std::array<int, 8>, 8> *pieces, std::vector<Move> *moves);
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "packed_board.h"
+
+namespace PositionBatches {
+    // boards a kernel works on at once, their bitboards fit in L1
+    inline const size_t BLOCK = 64;
+}  // namespace PositionBatches
+
+// Lots of positions, for asking the same question about all of them.
+//
+// Boards are stored as PackedBoards turned on their side: column k holds byte k of every board,
+// so a kernel reads the same byte of consecutive boards and the compiler can vectorize across boards.
+// The kernels unpack a block of boards into bitboards and answer with branch free fills instead of
+// generating moves, and give the same answers as is_under_attack and get_legal_positions.
+// Each side is expected to have at most one king.
+class PositionBatch {
+   public:
+    void add(std::array<std::array<int, 8>, 8> *pieces, int color_to_move);
+    void add(PackedBoard *board, int color_to_move);
+    void clear();
+
+    size_t size() { return colors.size(); }
+    PackedBoard board(size_t index);
+    int color_to_move(size_t index) { return colors[index] ? Piece::Black : Piece::White; }
+
+    // One answer per position, in the order they were added
+    void in_check(std::vector<uint8_t> *results);
+    void legal_move_count(std::vector<uint16_t> *results);
+    void is_mate(std::vector<uint8_t> *results);
+
+   private:
+    std::array<std::vector<uint8_t>, 32> columns;
+    std::vector<uint8_t> colors;  // 0 white to move, 1 black
+
+    template <typename F>
+    void for_each_block(F f);
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <array>
+#include <tuple>
+#include <vector>
+
+#include "board.h"
+#include "move.h"
+#include "raylib.h"
+
+namespace Constants {
+    inline const int SQUARE_LENGTH = 48;
+    inline const Color SQUARE_LIGHT = Color{235, 236, 208, 255};
+    inline const Color SQUARE_DARK = Color{119, 149, 86, 255};
+    inline const Color SQUARE_SELECTED = Color{66, 81, 49, 255};
+    inline const Color TRANSPARENT = Color{0, 0, 0, 0};
+    inline const Color BOOK_MOVE = Color{66, 81, 49, 160};
+    inline const Color MATE_MOVE = Color{200, 40, 40, 180};
+}  // namespace Constants
+
+struct Square {
+    // static const int None = 0;
+    static const int Selected = 0b00001;  // 1
+    static const int Indicator = 0b0010;  // 2
+                                          //
+    static const int Dark = 0b01000;      // 8
+    static const int Light = 0b10000;     // 16
+};
+
+int square_color(int a);
+bool square_is_selected(int a);
+bool square_is_indicator(int a);
+
+Rectangle rectangle_from_x_y(int x, int y);
+
+std::tuple<int, Texture2D> load_piece_texture(int piece);
+std::vector<std::tuple<int, Texture2D>> load_textures(std::array<std::array<int, 8>, 8> *pieces);
+void unload_textures(std::vector<std::tuple<int, Texture2D>> *piece_textures);
+
+std::array<std::array<int, 8>, 8> init_squares();
+
+void draw_piece_texture(Texture2D piece_texture, Rectangle dest_rect);
+void draw_piece_texture(Texture2D piece_texture, int x, int y);
+void draw_pieces(std::array<std::array<int, 8>, 8> *pieces, std::vector<std::tuple<int, Texture2D>> *piece_textures);
+void draw_squares(std::array<std::array<int, 8>, 8> *squares);
+// Line from the center of the move's square to the center of where it goes
+void draw_move_arrow(Move move, Color color);
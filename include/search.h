@@ -0,0 +1,25 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "move.h"
+
+namespace Score {
+    inline const int MATE = 30000;
+    inline const int INFINITE = 32000;
+    inline const std::array<int, 8> PIECE_VALUES = {0, 100, 0, 320, 330, 500, 900, 0};  // by piece_type
+}  // namespace Score
+
+typedef struct SearchResult {
+    Move best_move = 0;
+    int score = 0;  // centipawns for the side to move
+    int depth = 0;  // last depth that finished
+    size_t nodes = 0;
+} SearchResult;
+
+// Material, from color's point of view
+int evaluate(std::array<std::array<int, 8>, 8> *pieces, int color);
+
+// Iterative deepening alpha-beta with a capture search at the leaves, stops after max_nodes
+SearchResult search(std::array<std::array<int, 8>, 8> *pieces, int color, size_t max_nodes);
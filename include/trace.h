@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Hot path tracing, compiled in with -DCHESS_TRACE=ON. Without it the macros are empty and cost nothing.
+//
+// Every thread records into its own ring buffer, so recording never takes a lock. The most recent
+// events can be written out as Chrome trace_event JSON (chrome://tracing, Perfetto).
+// Event names must be string literals, only the pointer is stored.
+namespace Trace {
+    inline const size_t RING_SIZE = 1 << 15;  // events kept per thread
+}  // namespace Trace
+
+struct TraceCounter {
+    static const int NodesGenerated = 0;  // positions returned by the move generator
+    static const int BoardClones = 1;     // boards copied to try a move
+    static const int LegalityChecks = 2;  // is_under_attack calls
+    static const int Count = 3;
+};
+
+typedef struct TraceEvent {
+    const char *name;
+    uint64_t start_ns;
+    uint64_t duration_ns;  // or the value, for counter events
+    bool is_counter;
+} TraceEvent;
+
+uint64_t trace_now();
+void trace_record(const char *name, uint64_t start_ns, uint64_t end_ns);
+void trace_record_counter(const char *name, uint64_t value);
+void trace_count(int counter, uint64_t amount);
+// running total of a counter over every thread
+uint64_t trace_counter(int counter);
+
+// Durations of this thread's last n events called name, oldest first
+std::vector<uint64_t> trace_recent(const char *name, size_t n);
+uint64_t trace_percentile(std::vector<uint64_t> values, double percentile);
+
+bool trace_write_chrome_json(std::string path);
+
+class TraceScope {
+   public:
+    TraceScope(const char *name) : name(name), start(trace_now()) {}
+    ~TraceScope() { trace_record(name, start, trace_now()); }
+
+   private:
+    const char *name;
+    uint64_t start;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#ifdef CHESS_TRACE
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+// for spans that don't fit a scope, start_ns from trace_now()
+#define TRACE_RECORD(name, start_ns) trace_record(name, start_ns, trace_now())
+#define TRACE_COUNT(counter, amount) trace_count(counter, amount)
+#else
+#define TRACE_SCOPE(name)
+#define TRACE_RECORD(name, start_ns)
+#define TRACE_COUNT(counter, amount)
+#endif
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "board.h"
+
+// One labelled training position in 32 bytes
+//
+//   occupancy  bit per square, a1 = bit 0 ... h8 = bit 63
+//   pieces     4 bits per occupied square in square order, white << 3 | piece_type
+//   score      search score in centipawns for the side to move
+//   result     game result for the side to move, 1 won, 0 draw, -1 lost
+typedef struct PackedPosition {
+    uint64_t occupancy;
+    uint8_t pieces[16];
+    int16_t score;
+    uint16_t ply;
+    uint8_t color;  // side to move, 0 white 1 black
+    int8_t result;
+    uint8_t reserved[2];
+} PackedPosition;
+static_assert(sizeof(PackedPosition) == 32);
+
+PackedPosition pack_position(std::array<std::array<int, 8>, 8> *pieces, int color_to_move);
+void unpack_position(PackedPosition *packed, std::array<std::array<int, 8>, 8> *pieces, int *color_to_move);
+
+// Appends positions to dir/prefix-N.bin, starting a new file every positions_per_chunk positions.
+// Existing chunks are never rewritten, a restarted writer continues after the last one.
+class ChunkWriter {
+   public:
+    ChunkWriter(std::string dir, std::string prefix, size_t positions_per_chunk);
+    ~ChunkWriter();
+    ChunkWriter(const ChunkWriter &) = delete;
+    ChunkWriter &operator=(const ChunkWriter &) = delete;
+
+    bool write(PackedPosition *position);
+
+   private:
+    std::string dir;
+    std::string prefix;
+    size_t positions_per_chunk;
+    int chunk = 0;
+    size_t written = 0;
+    FILE *file = nullptr;
+
+    bool open_chunk();
+};
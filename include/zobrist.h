@@ -0,0 +1,27 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "board.h"
+
+namespace Zobrist {
+    // Keys are laid out like polyglot's Random64 table:
+    //   [0, 768)   piece on square, 64 * kind + square
+    //   [768, 772) castling rights
+    //   [772, 780) en passant file, never used since the rules have no en passant
+    //   780        white to move
+    inline const int CASTLING = 768;  // white short, white long, black short, black long
+    inline const int TURN = 780;
+    extern const std::array<uint64_t, 781> Random64;
+}  // namespace Zobrist
+
+// polyglot piece kind, black pawn = 0, white pawn = 1, ... white king = 11
+int zobrist_piece_kind(int piece);
+uint64_t zobrist_piece_key(int piece, Position position);
+// Castling rights for every king and rook still on its starting square
+uint64_t zobrist_castling_key(std::array<std::array<int, 8>, 8> *pieces);
+
+uint64_t hash_position(std::array<std::array<int, 8>, 8> *pieces, int color_to_move);
+// Key of the position after moving initial -> final, call before move_piece
+uint64_t hash_after_move(uint64_t key, std::array<std::array<int, 8>, 8> *pieces, Position initial, Position final);
@@ -0,0 +1,330 @@
+#include "bitbase.h"
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <tuple>
+
+#include "mapped_file.h"
+#include "move.h"
+
+namespace {
+    typedef struct BitbaseTable {
+        std::string material;
+        std::vector<int> pieces;
+        const unsigned char *data;
+        size_t size;
+    } BitbaseTable;
+
+    std::vector<BitbaseTable> tables;
+    std::vector<std::unique_ptr<MappedFile>> mapped_files;
+
+    // "KRKP" -> white king, white rook, black king, black pawn. Empty if it isn't a material set
+    std::vector<int> parse_material(std::string material) {
+        std::vector<int> result;
+        int color = 0;
+        for (char c : material) {
+            int type = Piece::None;
+            switch (c) {
+                case 'K':
+                    type = Piece::King;
+                    color = (color == 0) ? Piece::White : Piece::Black;
+                    break;
+                case 'Q':
+                    type = Piece::Queen;
+                    break;
+                case 'R':
+                    type = Piece::Rook;
+                    break;
+                case 'B':
+                    type = Piece::Bishop;
+                    break;
+                case 'N':
+                    type = Piece::Knight;
+                    break;
+                case 'P':
+                    type = Piece::Pawn;
+                    break;
+                default:
+                    return {};
+            }
+            if (color == 0) {
+                return {};
+            }
+            result.push_back(color | type);
+        }
+        // exactly two kings, the second one starting black's pieces
+        if (std::count_if(result.begin(), result.end(), [](int p) { return piece_type(p) == Piece::King; }) != 2) {
+            return {};
+        }
+        return result;
+    }
+
+    size_t position_count(size_t piece_count) { return (size_t)2 << (6 * piece_count); }
+
+    int read_value(const unsigned char *data, size_t index) { return (data[index >> 2] >> ((index & 3) * 2)) & 0b11; }
+
+    // Finds which board square each of the table's pieces is on, mirrored swaps colors and flips the ranks
+    bool match_table(BitbaseTable *table, std::vector<std::tuple<int, int>> *board_pieces, bool mirrored, size_t *index) {
+        if (table->pieces.size() != board_pieces->size()) {
+            return false;
+        }
+        std::vector<bool> used(board_pieces->size(), false);
+        size_t result = 0;
+        for (int piece : table->pieces) {
+            bool found = false;
+            for (size_t i = 0; i < board_pieces->size(); i++) {
+                auto [board_piece, square] = (*board_pieces)[i];
+                if (mirrored) {
+                    board_piece = opposite_color(piece_color(board_piece)) | piece_type(board_piece);
+                    square ^= 56;
+                }
+                if (!used[i] && board_piece == piece) {
+                    used[i] = true;
+                    result = result * 64 + square;
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) {
+                return false;
+            }
+        }
+        *index = result;
+        return true;
+    }
+
+    // Values while generating, Wdl:: plus these
+    const unsigned char UNDECIDED = 3;
+    const unsigned char INVALID = 4;
+
+    typedef struct Successors {
+        std::vector<uint32_t> counts;
+        // position index, or position_count + Wdl:: of a capture that left the table's material
+        std::vector<uint32_t> children;
+        bool ok = true;
+    } Successors;
+
+    void generate_successors(std::vector<int> *material, size_t first, size_t last, std::vector<unsigned char> *values, Successors *successors) {
+        size_t n = material->size();
+        size_t half = position_count(n) / 2;
+        size_t total = position_count(n);
+
+        for (size_t index = first; index < last; index++) {
+            int color = (index < half) ? Piece::White : Piece::Black;
+            std::vector<int> squares(n);
+            size_t rest = index % half;
+            for (int k = n - 1; k >= 0; k--) {
+                squares[k] = rest % 64;
+                rest /= 64;
+            }
+
+            std::array<std::array<int, 8>, 8> pieces{};
+            bool overlap = false;
+            for (size_t k = 0; k < n; k++) {
+                Position position = position_from_square_index(squares[k]);
+                if (pieces[position.x][position.y]) {
+                    overlap = true;
+                }
+                pieces[position.x][position.y] = (*material)[k];
+            }
+            // the side that just moved can't be left in check
+            if (overlap || is_under_attack(opposite_color(color), &pieces)) {
+                (*values)[index] = INVALID;
+                successors->counts.push_back(0);
+                continue;
+            }
+
+            uint32_t count = 0;
+            for (size_t k = 0; k < n; k++) {
+                if (piece_color((*material)[k]) != color) {
+                    continue;
+                }
+                Position from = position_from_square_index(squares[k]);
+                for (auto &to : get_legal_positions(&pieces, from.x, from.y)) {
+                    count++;
+                    if (pieces[to.x][to.y]) {
+                        // a capture leaves this material set, the smaller one must already be known
+                        auto cloned_pieces = pieces;
+                        move_piece(&cloned_pieces, from, to);
+                        int value = probe_bitbase(&cloned_pieces, opposite_color(color));
+                        if (value == Wdl::Unknown) {
+                            successors->ok = false;
+                            value = Wdl::Draw;
+                        }
+                        successors->children.push_back(total + value);
+                        continue;
+                    }
+                    size_t child = (color == Piece::White) ? index + half : index - half;
+                    size_t weight = (size_t)1 << (6 * (n - 1 - k));
+                    child = child - squares[k] * weight + square_index(to) * weight;
+                    successors->children.push_back(child);
+                }
+            }
+            successors->counts.push_back(count);
+
+            if (count == 0) {
+                // checkmated or stalemated
+                (*values)[index] = is_under_attack(color, &pieces) ? Wdl::Loss : Wdl::Draw;
+            }
+        }
+    }
+}  // namespace
+
+std::string material_name(std::array<std::array<int, 8>, 8> *pieces) {
+    std::string order = "KQRBNP";
+    std::string white;
+    std::string black;
+    for (int x = 0; x < 8; x++) {
+        for (int y = 0; y < 8; y++) {
+            int piece = (*pieces)[x][y];
+            if (piece) {
+                char letter = " P NBRQK"[piece_type(piece)];
+                (piece_color(piece) == Piece::White ? white : black).push_back(letter);
+            }
+        }
+    }
+    auto by_order = [&](char a, char b) { return order.find(a) < order.find(b); };
+    std::sort(white.begin(), white.end(), by_order);
+    std::sort(black.begin(), black.end(), by_order);
+    return white + black;
+}
+
+size_t bitbase_size(std::string material) {
+    auto pieces = parse_material(material);
+    if (pieces.empty()) {
+        return 0;
+    }
+    return position_count(pieces.size()) / 4;
+}
+
+bool generate_bitbase(std::string material, std::vector<unsigned char> *table, int thread_count) {
+    auto pieces = parse_material(material);
+    if (pieces.empty()) {
+        return false;
+    }
+    if (thread_count <= 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    size_t total = position_count(pieces.size());
+
+    // Every position's moves are generated once, in parallel
+    std::vector<unsigned char> values(total, UNDECIDED);
+    std::vector<Successors> parts(thread_count);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < thread_count; i++) {
+        size_t first = total * i / thread_count;
+        size_t last = total * (i + 1) / thread_count;
+        threads.emplace_back(generate_successors, &pieces, first, last, &values, &parts[i]);
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    // Flatten the successors, position index's children are children[offsets[index] .. offsets[index + 1])
+    std::vector<uint64_t> offsets;
+    offsets.reserve(total + 1);
+    std::vector<uint32_t> children;
+    for (auto &part : parts) {
+        if (!part.ok) {
+            return false;
+        }
+        uint64_t offset = children.size();
+        for (uint32_t count : part.counts) {
+            offsets.push_back(offset);
+            offset += count;
+        }
+        children.insert(children.end(), part.children.begin(), part.children.end());
+        part = {};
+    }
+    offsets.push_back(children.size());
+
+    // A position is won if a move reaches a lost one, lost if every move reaches a won one.
+    // Keep sweeping until nothing changes, whatever is left is a draw.
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t index = 0; index < total; index++) {
+            if (values[index] != UNDECIDED) {
+                continue;
+            }
+            bool win = false;
+            bool all_win = true;
+            for (uint64_t c = offsets[index]; c < offsets[index + 1]; c++) {
+                uint32_t child = children[c];
+                int value = (child >= total) ? (int)(child - total) : values[child];
+                if (value == Wdl::Loss) {
+                    win = true;
+                    break;
+                }
+                if (value != Wdl::Win) {
+                    all_win = false;
+                }
+            }
+            if (win) {
+                values[index] = Wdl::Win;
+                changed = true;
+            } else if (all_win) {
+                values[index] = Wdl::Loss;
+                changed = true;
+            }
+        }
+    }
+
+    table->assign(total / 4, 0);
+    for (size_t index = 0; index < total; index++) {
+        int value = values[index];
+        if (value == Wdl::Win || value == Wdl::Loss) {
+            (*table)[index >> 2] |= value << ((index & 3) * 2);
+        }
+    }
+    return true;
+}
+
+void register_bitbase(std::string material, const unsigned char *data, size_t size) {
+    auto pieces = parse_material(material);
+    if (pieces.empty() || size != bitbase_size(material)) {
+        return;
+    }
+    tables.push_back(BitbaseTable{material, pieces, data, size});
+}
+
+bool load_bitbase_file(std::string material, std::string path) {
+    auto file = std::make_unique<MappedFile>(path);
+    if (!file->is_open() || file->size() != bitbase_size(material)) {
+        return false;
+    }
+    register_bitbase(material, file->data(), file->size());
+    mapped_files.push_back(std::move(file));
+    return true;
+}
+
+int probe_bitbase(std::array<std::array<int, 8>, 8> *pieces, int color_to_move) {
+    std::vector<std::tuple<int, int>> board_pieces;
+    for (int x = 0; x < 8; x++) {
+        for (int y = 0; y < 8; y++) {
+            if ((*pieces)[x][y]) {
+                board_pieces.push_back({(*pieces)[x][y], square_index(Position{x, y})});
+            }
+        }
+    }
+    // bare kings can't win
+    if (board_pieces.size() == 2) {
+        return Wdl::Draw;
+    }
+
+    for (auto &table : tables) {
+        for (bool mirrored : {false, true}) {
+            size_t index;
+            if (!match_table(&table, &board_pieces, mirrored, &index)) {
+                continue;
+            }
+            int color = mirrored ? opposite_color(color_to_move) : color_to_move;
+            if (color == Piece::Black) {
+                index += position_count(table.pieces.size()) / 2;
+            }
+            return read_value(table.data, index);
+        }
+    }
+    return Wdl::Unknown;
+}
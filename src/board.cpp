@@ -0,0 +1,497 @@
+#include "board.h"
+
+#include "trace.h"
+
+Player player = Player(Piece::Black);
+
+int piece_type(int a) { return a & 0b00111; }
+
+int piece_color(int a) { return a & 0b11000; }
+
+int opposite_color(int color) {
+    switch (color) {
+        case Piece::Black:
+            return Piece::White;
+            break;
+        case Piece::White:
+            return Piece::Black;
+            break;
+    }
+    return 0;
+}
+
+// int transpose(std::array<std::array<int, 8>, 8> *pieces, Vector2 initial_position, int drow, int dcol) {
+//     int piece = (*pieces)[initial_position.x][initial_position.y];
+//     int y;
+//     switch (piece_color(piece)) {
+//         case Piece::Black:
+//             y = dcol;
+//             break;
+//         case Piece::White:
+//             y = -dcol;
+//             break;
+//     }
+//
+//     return (*pieces)[initial_position.x + drow][initial_position.y + y];
+// }
+
+// TODO: pick one of them
+// Vector2 transpose(std::array<std::array<int, 8>, 8> *pieces, Vector2 initial_position, int drow, int dcol) {
+//     int piece = (*pieces)[initial_position.x][initial_position.y];
+//     Vector2 final;
+//
+//     switch (piece_color(piece)) {
+//         case Piece::Black:
+//             final = {initial_position.x + drow, initial_position.y + dcol};
+//             break;
+//         case Piece::White:
+//             final = {initial_position.x + drow, initial_position.y - dcol};
+//             break;
+//     }
+//     return final;
+// }
+
+int forward(int color, int col, int dcol) {
+    if (color == player.color) {
+        return col + dcol;
+    } else {
+        return col - dcol;
+    }
+    // switch (color) {
+    //     case Piece::Black:
+    //         return col + dcol;
+    //         break;
+    //     case Piece::White:
+    //         return col - dcol;
+    //         break;
+    // }
+    return 0;
+}
+
+std::vector<Position> get_positions_in_directions(std::array<std::array<int, 8>, 8> *pieces, Position starting_position, std::vector<Direction> directions) {
+    //
+    int starting_row = starting_position.x;
+    int starting_column = starting_position.y;
+    int starting_piece = (*pieces)[starting_row][starting_column];
+
+    std::vector<Position> result;
+    for (auto &direction : directions) {
+        Position temp_pos = Position{starting_row, starting_column};
+        // debug(std::format("Bee  {}", temp_pos.y));
+        switch (direction) {
+            case (Direction::North):
+                while (temp_pos.y < 7) {
+                    temp_pos.y++;
+                    int p = (*pieces)[starting_row][temp_pos.y];
+                    if (p) {
+                        if (piece_color(p) != piece_color(starting_piece)) {
+                            result.push_back({starting_row, temp_pos.y});
+                        }
+                        break;
+                    }
+                    result.push_back({starting_row, temp_pos.y});
+                }
+                break;
+            case (Direction::East):
+                while (temp_pos.x < 7) {
+                    temp_pos.x++;
+                    int p = (*pieces)[temp_pos.x][starting_column];
+                    if (p) {
+                        if (piece_color(p) != piece_color(starting_piece)) {
+                            result.push_back({temp_pos.x, starting_column});
+                        }
+                        break;
+                    }
+                    result.push_back({temp_pos.x, starting_column});
+                }
+
+                break;
+            case (Direction::South):
+                while (temp_pos.y > 0) {
+                    temp_pos.y--;
+                    int p = (*pieces)[starting_row][temp_pos.y];
+                    if (p) {
+                        if (piece_color(p) != piece_color(starting_piece)) {
+                            result.push_back({starting_row, temp_pos.y});
+                        }
+                        break;
+                    }
+                    result.push_back({starting_row, temp_pos.y});
+                    // debug(std::format("{}", temp_pos.y));
+                }
+
+                break;
+            case (Direction::West):
+                while (temp_pos.x > 0) {
+                    temp_pos.x--;
+                    int p = (*pieces)[temp_pos.x][starting_column];
+                    if (p) {
+                        if (piece_color(p) != piece_color(starting_piece)) {
+                            result.push_back({temp_pos.x, starting_column});
+                        }
+                        break;
+                    }
+                    result.push_back({temp_pos.x, starting_column});
+                    // debug(std::format("{}", temp_pos.y));
+                }
+                break;
+            case (Direction::NorthEast):
+                while (temp_pos.y < 7 && temp_pos.x < 7) {
+                    temp_pos.x++;
+                    temp_pos.y++;
+                    int p = (*pieces)[temp_pos.x][temp_pos.y];
+                    if (p) {
+                        if (piece_color(p) != piece_color(starting_piece)) {
+                            result.push_back({temp_pos.x, temp_pos.y});
+                        }
+                        break;
+                    }
+                    result.push_back({temp_pos.x, temp_pos.y});
+                    // debug(std::format("{}", temp_pos.y));
+                }
+                break;
+            case (Direction::SouthEast):
+                while (temp_pos.y > 0 && temp_pos.x < 7) {
+                    temp_pos.x++;
+                    temp_pos.y--;
+                    int p = (*pieces)[temp_pos.x][temp_pos.y];
+                    if (p) {
+                        if (piece_color(p) != piece_color(starting_piece)) {
+                            result.push_back({temp_pos.x, temp_pos.y});
+                        }
+                        break;
+                    }
+                    result.push_back({temp_pos.x, temp_pos.y});
+                }
+                break;
+            case (Direction::SouthWest):
+                while (temp_pos.y > 0 && temp_pos.x > 0) {
+                    temp_pos.x--;
+                    temp_pos.y--;
+                    int p = (*pieces)[temp_pos.x][temp_pos.y];
+                    if (p) {
+                        if (piece_color(p) != piece_color(starting_piece)) {
+                            result.push_back({temp_pos.x, temp_pos.y});
+                        }
+                        break;
+                    }
+
+                    result.push_back({temp_pos.x, temp_pos.y});
+                }
+                break;
+            case (Direction::NorthWest):
+                while (temp_pos.y < 7 && temp_pos.x > 0) {
+                    temp_pos.x--;
+                    temp_pos.y++;
+                    int p = (*pieces)[temp_pos.x][temp_pos.y];
+                    if (p) {
+                        if (piece_color(p) != piece_color(starting_piece)) {
+                            result.push_back({temp_pos.x, temp_pos.y});
+                        }
+                        break;
+                    }
+                    result.push_back({temp_pos.x, temp_pos.y});
+                }
+                break;
+        }
+    }
+
+    return result;
+}
+
+bool position_is_within_board(Position position) {
+    //
+    return ((position.x >= 0) && (position.x <= 7) && (position.y >= 0) && (position.y <= 7));
+}
+
+/* Generic function for any piece */
+bool is_valid_primative_move(std::array<std::array<int, 8>, 8> *pieces, Position start_pos, Position end_pos) {
+    // No Pieces can move outside the board, checked before end_pos is used as an index
+    if (!position_is_within_board(end_pos)) {
+        return false;
+    }
+
+    int starting_piece = (*pieces)[start_pos.x][start_pos.y];
+    int ending_piece = (*pieces)[end_pos.x][end_pos.y];
+
+    // If we are moving nothing, it's not valid
+    if (!starting_piece) {
+        return false;
+    }
+    // No 2 Pieces can occupy same position
+    if (starting_piece && ending_piece) {
+        if (piece_color(starting_piece) == piece_color(ending_piece)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<Position> get_primative_knight_positions(std::array<std::array<int, 8>, 8> *pieces, int x, int y) {
+    std::vector<Position> result;
+
+    std::array<Position, 8> candidates = {{
+        // top
+        {x - 2, y + 1},
+        {x - 1, y + 2},
+        {x + 1, y + 2},
+        {x + 2, y + 1},
+        // bottom
+        {x - 2, y - 1},
+        {x - 1, y - 2},
+        {x + 1, y - 2},
+        {x + 2, y - 1},
+    }};
+    for (const auto &[a, b] : candidates) {
+        if (is_valid_primative_move(pieces, Position{x, y}, Position{a, b})) {
+            result.push_back({a, b});
+        };
+    }
+    return result;
+}
+
+std::vector<Position> get_primative_king_positions(std::array<std::array<int, 8>, 8> *pieces, int x, int y) {
+    std::vector<Position> result;
+
+    std::array<Position, 8> candidates = {{
+        // top
+        {x - 1, y + 1},
+        {x, y + 1},
+        {x + 1, y + 1},
+        //  >:3
+        {x - 1, y},
+        {x + 1, y},
+        // bottom (you)
+        {x - 1, y - 1},
+        {x, y - 1},
+        {x + 1, y - 1},
+    }};
+    for (const auto &[a, b] : candidates) {
+        if (is_valid_primative_move(pieces, Position{x, y}, Position{a, b})) {
+            result.push_back({a, b});
+        };
+    }
+
+    // TODO: Casting O-O and O-O-O
+    return result;
+}
+
+std::vector<Position> get_primative_pawn_positions(std::array<std::array<int, 8>, 8> *pieces, int x, int y) {
+    std::vector<Position> result;
+
+    int piece = (*pieces)[x][y];
+    int color = piece_color(piece);
+
+    Position inital_position = Position{x, y};
+    Position possible_position;
+
+    // Not eating
+    possible_position = Position{x, forward(color, y, 1)};
+    if (is_valid_primative_move(pieces, inital_position, possible_position)) {
+        // If theres nobody 1 squares forward from me
+        if ((*pieces)[possible_position.x][possible_position.y] == Piece::None) {
+            // i can move up one
+            result.push_back(possible_position);
+
+            // additionally, if im on the second column
+            if ((y == 1 && color == player.color) || (y == 6 && color == opposite_color(player.color))) {
+                possible_position = Position{x, forward(color, y, 2)};
+                if (is_valid_primative_move(pieces, inital_position, possible_position)) {
+                    // and theres nobody 2 squares forward from me
+                    if ((*pieces)[possible_position.x][possible_position.y] == Piece::None) {
+                        // i can move up two
+                        result.push_back(possible_position);
+                    }
+                }
+            }
+        }
+    }
+
+    // Eating
+    possible_position = Position{x - 1, forward(color, y, 1)};  // top left
+    if (is_valid_primative_move(pieces, inital_position, possible_position)) {
+        // If theres a piece in top left of me
+        auto top_left_piece = (*pieces)[possible_position.x][possible_position.y];
+        if (top_left_piece) {
+            // If the piece in front has opposite color of me
+            if (color != piece_color(top_left_piece)) {
+                // i can eat it
+                result.push_back(possible_position);
+            }
+        }
+    }
+
+    possible_position = Position{x + 1, forward(color, y, 1)};  // top right
+    if (is_valid_primative_move(pieces, inital_position, possible_position)) {
+        // If theres a piece in top right of me
+        auto top_left_piece = (*pieces)[possible_position.x][possible_position.y];
+        if (top_left_piece) {
+            // If the piece in front has opposite color of me
+            if (color != piece_color(top_left_piece)) {
+                // i can eat it
+                result.push_back(possible_position);
+            }
+        }
+    }
+
+    // TODO: En passant
+
+    return result;
+}
+
+std::vector<Position> get_primative_positions(std::array<std::array<int, 8>, 8> *pieces, int x, int y) {
+    std::vector<Position> result;
+
+    int starting_piece = (*pieces)[x][y];
+
+    std::vector<Direction> directions;
+    switch (piece_type(starting_piece)) {
+        // case Piece::Pawn:
+        // case Piece::Knight:
+        case (Piece::Bishop):
+            directions = Directions::Bishop;
+            break;
+        case (Piece::Rook):
+            directions = Directions::Rook;
+            break;
+        case (Piece::Queen):
+            directions = Directions::Queen;
+            break;
+            // case Piece::King:
+    }
+    if (!directions.empty()) {
+        auto positions = get_positions_in_directions(pieces, Position{x, y}, directions);
+        result.insert(result.end(), positions.begin(), positions.end());
+        TRACE_COUNT(TraceCounter::NodesGenerated, result.size());
+        return result;
+    }
+
+    if (piece_type(starting_piece) == Piece::Pawn) {
+        auto positions = get_primative_pawn_positions(pieces, x, y);
+        result.insert(result.end(), positions.begin(), positions.end());
+    } else if (piece_type(starting_piece) == Piece::Knight) {
+        auto positions = get_primative_knight_positions(pieces, x, y);
+        result.insert(result.end(), positions.begin(), positions.end());
+    } else if (piece_type(starting_piece) == Piece::King) {
+        auto positions = get_primative_king_positions(pieces, x, y);
+        result.insert(result.end(), positions.begin(), positions.end());
+    }
+
+    // debug(std::format("finaly result {}", result));
+    TRACE_COUNT(TraceCounter::NodesGenerated, result.size());
+    return result;
+}
+
+std::vector<Position> get_attacking_positions(std::array<std::array<int, 8>, 8> *pieces, int x, int y) {
+    // TODO: pawn moving forward is primative but not attacking
+    return get_primative_positions(pieces, x, y);
+}
+
+std::vector<Position> get_all_attacking_positions(int color, std::array<std::array<int, 8>, 8> *pieces) {
+    std::vector<Position> result;
+    for (int x = 0; x < 8; x++) {
+        for (int y = 0; y < 8; y++) {
+            int piece = (*pieces)[x][y];
+            if (piece) {
+                if (piece_color(piece) == color) {
+                    auto attacking_positions = get_attacking_positions(pieces, x, y);
+                    result.insert(result.end(), attacking_positions.begin(), attacking_positions.end());
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+bool is_under_attack(int color, std::array<std::array<int, 8>, 8> *pieces) {
+    TRACE_COUNT(TraceCounter::LegalityChecks, 1);
+    std::vector<Position> all_attacking_positions;
+
+    all_attacking_positions = get_all_attacking_positions(opposite_color(color), pieces);
+
+    // debug(std::format("000000"));
+    for (auto &[a, b] : all_attacking_positions) {
+        // debug(std::format("attacking positions {} {}", x, y));
+        if (piece_type((*pieces)[a][b]) == Piece::King && (piece_color((*pieces)[a][b]) == color)) {
+            return true;
+        }
+    }
+    return false;
+};
+
+void move_piece(std::array<std::array<int, 8>, 8> *pieces, Position initial, Position final) {
+    (*pieces)[final.x][final.y] = (*pieces)[initial.x][initial.y];
+    if (initial != final) {
+        (*pieces)[initial.x][initial.y] = Piece::None;
+    }
+}
+
+/* Moves that don't leave the piece's own king under attack, regardless of whose turn it is */
+std::vector<Position> get_legal_positions(std::array<std::array<int, 8>, 8> *pieces, int x, int y) {
+    std::vector<Position> result;
+
+    auto primative_positions = get_primative_positions(pieces, x, y);
+    for (auto &[a, b] : primative_positions) {
+        auto cloned_pieces = (*pieces);              // cloned_pieces contains a clone of pieces
+        move_piece(&cloned_pieces, {x, y}, {a, b});  // thats why we can modify without affecting our real board
+        TRACE_COUNT(TraceCounter::BoardClones, 1);
+
+        // If i make this move and im not under attack after moving, then im safe to do so
+        if (!is_under_attack(piece_color((*pieces)[x][y]), &cloned_pieces)) {
+            result.push_back({a, b});
+        }
+    }
+    return result;
+}
+
+// white moves on even move numbers, black on odd ones
+int side_to_move(int number_of_moves) {
+    if (number_of_moves % 2 == 0) {
+        return Piece::White;
+    }
+    return Piece::Black;
+}
+
+std::vector<Position> get_valid_positions(std::array<std::array<int, 8>, 8> *pieces, int x, int y) {
+    // Only the side to move can move
+    if (piece_color((*pieces)[x][y]) != side_to_move(player.number_of_moves)) {
+        return {};
+    }
+    return get_legal_positions(pieces, x, y);
+}
+
+std::array<std::array<int, 8>, 8> init_pieces(int color) {
+    std::array<std::array<int, 8>, 8> pieces;
+    for (int x = 0; x < 8; x++) {
+        for (int y = 0; y < 8; y++) {
+            pieces[x][y] = 0;
+        }
+    }
+    // Load Pawns //
+    for (int x = 0; x < 8; x++) {
+        pieces[x][1] = player.color | Piece::Pawn;
+        pieces[x][6] = opposite_color(player.color) | Piece::Pawn;
+    }
+    // my pieces //
+    pieces[0][0] = player.color | Piece::Rook;
+    pieces[1][0] = player.color | Piece::Knight;
+    pieces[2][0] = player.color | Piece::Bishop;
+    pieces[3][0] = player.color | Piece::Queen;
+    pieces[4][0] = player.color | Piece::King;
+    pieces[5][0] = player.color | Piece::Bishop;
+    pieces[6][0] = player.color | Piece::Knight;
+    pieces[7][0] = player.color | Piece::Rook;
+
+    // opponents pieces //
+    pieces[0][7] = opposite_color(player.color) | Piece::Rook;
+    pieces[1][7] = opposite_color(player.color) | Piece::Knight;
+    pieces[2][7] = opposite_color(player.color) | Piece::Bishop;
+    pieces[3][7] = opposite_color(player.color) | Piece::Queen;
+    pieces[4][7] = opposite_color(player.color) | Piece::King;
+    pieces[5][7] = opposite_color(player.color) | Piece::Bishop;
+    pieces[6][7] = opposite_color(player.color) | Piece::Knight;
+    pieces[7][7] = opposite_color(player.color) | Piece::Rook;
+
+    return pieces;
+}
@@ -0,0 +1,105 @@
+#include "book.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+    uint64_t read_big_endian(const unsigned char *p, int bytes) {
+        uint64_t value = 0;
+        for (int i = 0; i < bytes; i++) {
+            value = (value << 8) | p[i];
+        }
+        return value;
+    }
+
+    void write_big_endian(unsigned char *p, uint64_t value, int bytes) {
+        for (int i = bytes - 1; i >= 0; i--) {
+            p[i] = value & 0xff;
+            value >>= 8;
+        }
+    }
+}  // namespace
+
+Book::Book(std::string path) : file(path) {}
+
+BookEntry Book::entry(size_t i) {
+    const unsigned char *p = file.data() + i * BookFile::ENTRY_SIZE;
+    return BookEntry{
+        read_big_endian(p, 8),
+        (Move)read_big_endian(p + 8, 2),
+        (uint16_t)read_big_endian(p + 10, 2),
+        (uint32_t)read_big_endian(p + 12, 4),
+    };
+}
+
+std::vector<BookEntry> Book::find(uint64_t key) {
+    std::vector<BookEntry> result;
+    if (!is_open()) {
+        return result;
+    }
+
+    // lower bound on the key, then walk forward while it still matches
+    size_t low = 0;
+    size_t high = entry_count();
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (read_big_endian(file.data() + middle * BookFile::ENTRY_SIZE, 8) < key) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    for (size_t i = low; i < entry_count(); i++) {
+        BookEntry e = entry(i);
+        if (e.key != key) {
+            break;
+        }
+        result.push_back(e);
+    }
+    return result;
+}
+
+bool Book::pick(uint64_t key, uint64_t random, Move *move) {
+    auto entries = find(key);
+    uint64_t total = 0;
+    for (auto &e : entries) {
+        total += e.weight;
+    }
+    if (total == 0) {
+        return false;
+    }
+
+    uint64_t target = random % total;
+    for (auto &e : entries) {
+        if (target < e.weight) {
+            *move = e.move;
+            return true;
+        }
+        target -= e.weight;
+    }
+    return false;
+}
+
+bool write_book(std::vector<BookEntry> *entries, std::string path) {
+    std::sort(entries->begin(), entries->end(), [](const BookEntry &lhs, const BookEntry &rhs) {
+        if (lhs.key != rhs.key) {
+            return lhs.key < rhs.key;
+        }
+        return lhs.weight > rhs.weight;
+    });
+
+    FILE *file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    bool ok = true;
+    for (auto &e : (*entries)) {
+        unsigned char buffer[BookFile::ENTRY_SIZE];
+        write_big_endian(buffer, e.key, 8);
+        write_big_endian(buffer + 8, e.move, 2);
+        write_big_endian(buffer + 10, e.weight, 2);
+        write_big_endian(buffer + 12, e.learn, 4);
+        ok = ok && std::fwrite(buffer, 1, sizeof(buffer), file) == sizeof(buffer);
+    }
+    return (std::fclose(file) == 0) && ok;
+}
@@ -0,0 +1,99 @@
+#include "fen.h"
+
+#include <cctype>
+
+#include "move.h"
+
+namespace {
+    int piece_from_letter(char c) {
+        int color = std::isupper((unsigned char)c) ? Piece::White : Piece::Black;
+        switch (std::tolower((unsigned char)c)) {
+            case 'p':
+                return color | Piece::Pawn;
+            case 'n':
+                return color | Piece::Knight;
+            case 'b':
+                return color | Piece::Bishop;
+            case 'r':
+                return color | Piece::Rook;
+            case 'q':
+                return color | Piece::Queen;
+            case 'k':
+                return color | Piece::King;
+        }
+        return Piece::None;
+    }
+}  // namespace
+
+bool board_from_fen(std::string fen, std::array<std::array<int, 8>, 8> *pieces, int *color_to_move) {
+    std::array<std::array<int, 8>, 8> result{};
+
+    // placement starts at a8 and goes rank by rank down to h1
+    int rank = 7;
+    int file = 0;
+    size_t i = 0;
+    for (; i < fen.size() && fen[i] != ' '; i++) {
+        char c = fen[i];
+        if (c == '/') {
+            if (file != 8 || rank == 0) {
+                return false;
+            }
+            rank--;
+            file = 0;
+        } else if (c >= '1' && c <= '8') {
+            file += c - '0';
+        } else {
+            int piece = piece_from_letter(c);
+            if (!piece || file > 7) {
+                return false;
+            }
+            Position position = position_from_square_index(rank * 8 + file);
+            result[position.x][position.y] = piece;
+            file++;
+        }
+        if (file > 8) {
+            return false;
+        }
+    }
+    if (rank != 0 || file != 8) {
+        return false;
+    }
+
+    int color = Piece::White;
+    if (i + 1 < fen.size() && fen[i + 1] == 'b') {
+        color = Piece::Black;
+    }
+
+    *pieces = result;
+    *color_to_move = color;
+    return true;
+}
+
+std::string fen_from_board(std::array<std::array<int, 8>, 8> *pieces, int color_to_move) {
+    std::string fen;
+    for (int rank = 7; rank >= 0; rank--) {
+        int empty = 0;
+        for (int file = 0; file < 8; file++) {
+            Position position = position_from_square_index(rank * 8 + file);
+            int piece = (*pieces)[position.x][position.y];
+            if (!piece) {
+                empty++;
+                continue;
+            }
+            if (empty) {
+                fen.push_back('0' + empty);
+                empty = 0;
+            }
+            char letter = " p nbrqk"[piece_type(piece)];
+            fen.push_back(piece_color(piece) == Piece::White ? std::toupper(letter) : letter);
+        }
+        if (empty) {
+            fen.push_back('0' + empty);
+        }
+        if (rank > 0) {
+            fen.push_back('/');
+        }
+    }
+    fen += (color_to_move == Piece::White) ? " w - - 0 1" : " b - - 0 1";
+    return fen;
+}
@@ -0,0 +1,467 @@
+#include "game_server.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <sstream>
+
+#include "fen.h"
+#include "move.h"
+#include "trace.h"
+
+uint32_t GameSlab::allocate() {
+    if (!free_slots.empty()) {
+        uint32_t slot = free_slots.back();
+        free_slots.pop_back();
+        return slot;
+    }
+    if (capacity % GameServerLimits::GAMES_PER_SLAB == 0) {
+        slabs.push_back(std::make_unique<GameState[]>(GameServerLimits::GAMES_PER_SLAB));
+    }
+    return capacity++;
+}
+
+void GameSlab::release(uint32_t slot) {
+    GameState *game = at(slot);
+    game->status = GameStatus::Free;
+    game->generation++;
+    free_slots.push_back(slot);
+}
+
+const char *game_status_name(int status) {
+    switch (status) {
+        case GameStatus::Playing:
+            return "playing";
+        case GameStatus::WhiteWins:
+            return "white_wins";
+        case GameStatus::BlackWins:
+            return "black_wins";
+        case GameStatus::Stalemate:
+            return "stalemate";
+        default:
+            return "free";
+    }
+}
+
+bool parse_game_id(std::string s, uint64_t *id) {
+    auto [end, error] = std::from_chars(s.data(), s.data() + s.size(), *id);
+    return error == std::errc() && end == s.data() + s.size();
+}
+
+// Playing, or how the game ended if color_to_move can't move
+int game_status(std::array<std::array<int, 8>, 8> *pieces, int color_to_move) {
+    if (has_legal_moves(pieces, color_to_move)) {
+        return GameStatus::Playing;
+    }
+    if (!is_under_attack(color_to_move, pieces)) {
+        return GameStatus::Stalemate;
+    }
+    return (color_to_move == Piece::White) ? GameStatus::BlackWins : GameStatus::WhiteWins;
+}
+
+// The rules find kings by looking for them, so a game needs exactly one per side,
+// and the side that just moved can't have left its king in check.
+// Pawns can't stand on the first or last rank, there's no promotion to get them off it
+bool is_possible_position(std::array<std::array<int, 8>, 8> *pieces, int color_to_move) {
+    int white_kings = 0;
+    int black_kings = 0;
+    for (int x = 0; x < 8; x++) {
+        for (int y = 0; y < 8; y++) {
+            int piece = (*pieces)[x][y];
+            if (piece && piece_type(piece) == Piece::King) {
+                (piece_color(piece) == Piece::White ? white_kings : black_kings)++;
+            }
+            if (piece && piece_type(piece) == Piece::Pawn && (y == 0 || y == 7)) {
+                return false;
+            }
+        }
+    }
+    return white_kings == 1 && black_kings == 1 && !is_under_attack(opposite_color(color_to_move), pieces);
+}
+
+GameState *GameShard::find(uint64_t id) {
+    uint32_t slot = (uint32_t)id >> GameServerLimits::SHARD_BITS;
+    if ((int)(id & (GameServerLimits::MAX_SHARDS - 1)) != index || !slab.contains(slot)) {
+        return nullptr;
+    }
+    GameState *game = slab.at(slot);
+    if (game->status == GameStatus::Free || game->generation != (uint32_t)(id >> 32)) {
+        return nullptr;
+    }
+    return game;
+}
+
+std::string GameShard::handle(std::string line) {
+    TRACE_SCOPE("game_command");
+    std::istringstream words(line);
+    std::string command;
+    std::string id_text;
+    words >> command >> id_text;
+
+    if (command == "new") {
+        std::array<std::array<int, 8>, 8> pieces = init_pieces(player.color);
+        int color = Piece::White;
+        size_t fen_start = line.find_first_not_of(' ', line.find("new") + 3);
+        if (fen_start != std::string::npos && !board_from_fen(line.substr(fen_start), &pieces, &color)) {
+            return "error bad fen";
+        }
+        if (!is_possible_position(&pieces, color)) {
+            return "error impossible position";
+        }
+        uint32_t slot = slab.allocate();
+        GameState *game = slab.at(slot);
+        game->board = pack_board(&pieces);
+        game->ply = (color == Piece::White) ? 0 : 1;
+        game->status = game_status(&pieces, color);
+        uint64_t id = (uint64_t)game->generation << 32 | slot << GameServerLimits::SHARD_BITS | index;
+        return "ok " + std::to_string(id);
+    }
+
+    uint64_t id;
+    GameState *game = nullptr;
+    if (!parse_game_id(id_text, &id) || !(game = find(id))) {
+        return "error unknown game";
+    }
+    std::array<std::array<int, 8>, 8> pieces;
+    unpack_board(&game->board, &pieces);
+    int color = side_to_move(game->ply);
+
+    if (command == "move") {
+        std::string move_text;
+        words >> move_text;
+        Move move;
+        if (!move_from_string(move_text, &move)) {
+            return "error bad move";
+        }
+        if (game->status != GameStatus::Playing) {
+            return "error game is over";
+        }
+        Position from = move_from(move);
+        Position to = move_to(move);
+        if (piece_color(pieces[from.x][from.y]) != color) {
+            return "error illegal move";
+        }
+        auto legal = get_legal_positions(&pieces, from.x, from.y);
+        if (std::find(legal.begin(), legal.end(), to) == legal.end()) {
+            return "error illegal move";
+        }
+        move_piece(&pieces, from, to);
+        game->board = pack_board(&pieces);
+        game->ply++;
+        game->status = game_status(&pieces, opposite_color(color));
+        return std::string("ok ") + game_status_name(game->status);
+    } else if (command == "moves") {
+        std::string result = "ok";
+        if (game->status == GameStatus::Playing) {
+            for (Move move : get_legal_moves(&pieces, color)) {
+                result += " " + move_to_string(move);
+            }
+        }
+        return result;
+    } else if (command == "status") {
+        return std::string("ok ") + game_status_name(game->status) + " " + fen_from_board(&pieces, color);
+    } else if (command == "end") {
+        slab.release((uint32_t)id >> GameServerLimits::SHARD_BITS);
+        return "ok";
+    }
+    return "error unknown command";
+}
+
+GameServer::GameServer(int threads) {
+    threads = std::clamp(threads, 1, GameServerLimits::MAX_SHARDS);
+    for (int i = 0; i < threads; i++) {
+        shards.push_back(std::make_unique<GameShard>(i));
+    }
+    for (auto &shard : shards) {
+        shard->thread = std::thread(&GameServer::work, this, shard.get());
+    }
+}
+
+GameServer::~GameServer() {
+    stop();
+    for (auto &shard : shards) {
+        {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+        }
+        shard->ready.notify_all();
+        shard->thread.join();
+    }
+    for (auto &[fd, connection] : connections) {
+        close(fd);
+    }
+    for (int fd : {listen_fd, epoll_fd, wake_fd}) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+bool GameServer::listen(std::string path) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::strcpy(address.sun_path, path.c_str());
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
+        return false;
+    }
+    // a socket left behind by a previous run would make bind fail
+    unlink(path.c_str());
+    if (bind(listen_fd, (sockaddr *)&address, sizeof(address)) < 0 || ::listen(listen_fd, SOMAXCONN) < 0) {
+        return false;
+    }
+
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd < 0 || wake_fd < 0) {
+        return false;
+    }
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = listen_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &event);
+    event.data.fd = wake_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &event);
+    return true;
+}
+
+void GameServer::stop() {
+    stopping = true;
+    if (wake_fd >= 0) {
+        uint64_t one = 1;
+        [[maybe_unused]] auto written = write(wake_fd, &one, sizeof(one));
+    }
+}
+
+void GameServer::work(GameShard *shard) {
+    std::deque<std::tuple<int, uint64_t, std::string>> batch;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(shard->mutex);
+            shard->ready.wait(lock, [&] { return stopping || !shard->requests.empty(); });
+            if (shard->requests.empty()) {
+                return;
+            }
+            batch.swap(shard->requests);
+        }
+
+        std::vector<std::tuple<int, uint64_t, std::string>> done;
+        for (auto &[fd, serial, line] : batch) {
+            done.emplace_back(fd, serial, shard->handle(line));
+        }
+        batch.clear();
+
+        {
+            std::lock_guard<std::mutex> lock(answers_mutex);
+            for (auto &answer : done) {
+                answers.push_back(std::move(answer));
+            }
+        }
+        uint64_t one = 1;
+        [[maybe_unused]] auto written = write(wake_fd, &one, sizeof(one));
+    }
+}
+
+void GameServer::run() {
+    epoll_event events[256];
+    while (!stopping) {
+        int count = epoll_wait(epoll_fd, events, 256, -1);
+        for (int i = 0; i < count; i++) {
+            int fd = events[i].data.fd;
+            if (fd == listen_fd) {
+                accept_connections();
+            } else if (fd == wake_fd) {
+                collect_answers();
+            } else if (!connections.count(fd)) {
+                // closed earlier in this batch
+                continue;
+            } else if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                close_connection(fd);
+            } else {
+                if (events[i].events & EPOLLIN) {
+                    read_connection(fd);
+                }
+                if ((events[i].events & EPOLLOUT) && connections.count(fd)) {
+                    flush(fd);
+                }
+            }
+        }
+    }
+}
+
+void GameServer::accept_connections() {
+    while (true) {
+        int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+        Connection connection;
+        connection.serial = next_serial++;
+        connections[fd] = connection;
+    }
+}
+
+void GameServer::read_connection(int fd) {
+    auto it = connections.find(fd);
+    if (it == connections.end()) {
+        return;
+    }
+    Connection &connection = it->second;
+    char buffer[4096];
+    // the rest waits in the socket until these lines are answered
+    while (connection.in.size() < GameServerLimits::MAX_BUFFERED) {
+        ssize_t length = read(fd, buffer, sizeof(buffer));
+        if (length > 0) {
+            connection.in.append(buffer, length);
+            continue;
+        }
+        if (length == 0) {
+            // the client is done sending but still gets answers to everything it sent,
+            // flush closes the connection once they're all out
+            connection.read_closed = true;
+            if (!connection.in.empty() && connection.in.back() != '\n') {
+                connection.in += '\n';
+            }
+            break;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            close_connection(fd);
+            return;
+        }
+        break;
+    }
+    // nobody sends lines this long, don't keep buffering for them
+    if (connection.in.size() > GameServerLimits::MAX_LINE && connection.in.find('\n') == std::string::npos) {
+        close_connection(fd);
+        return;
+    }
+    dispatch(fd);
+}
+
+// Sends the connection's next complete line to the shard that owns its game
+void GameServer::dispatch(int fd) {
+    auto it = connections.find(fd);
+    if (it == connections.end()) {
+        return;
+    }
+    Connection &connection = it->second;
+    while (!connection.busy) {
+        size_t end = connection.in.find('\n');
+        if (end == std::string::npos) {
+            break;
+        }
+        std::string line = connection.in.substr(0, end);
+        connection.in.erase(0, end + 1);
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty()) {
+            continue;
+        }
+
+        std::istringstream words(line);
+        std::string command;
+        std::string id_text;
+        words >> command >> id_text;
+        size_t shard;
+        uint64_t id;
+        if (command != "new" && command != "move" && command != "moves" && command != "status" && command != "end") {
+            connection.out += "error unknown command\n";
+            continue;
+        } else if (command == "new") {
+            shard = next_shard++ % shards.size();
+        } else if (parse_game_id(id_text, &id) && (id & (GameServerLimits::MAX_SHARDS - 1)) < shards.size()) {
+            shard = id & (GameServerLimits::MAX_SHARDS - 1);
+        } else {
+            connection.out += "error unknown game\n";
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(shards[shard]->mutex);
+            shards[shard]->requests.emplace_back(fd, connection.serial, std::move(line));
+        }
+        shards[shard]->ready.notify_one();
+        connection.busy = true;
+    }
+    flush(fd);
+}
+
+void GameServer::flush(int fd) {
+    auto it = connections.find(fd);
+    if (it == connections.end()) {
+        return;
+    }
+    Connection &connection = it->second;
+    while (!connection.out.empty()) {
+        ssize_t length = send(fd, connection.out.data(), connection.out.size(), MSG_NOSIGNAL);
+        if (length < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                close_connection(fd);
+                return;
+            }
+            break;
+        }
+        connection.out.erase(0, length);
+    }
+    if (connection.out.size() > GameServerLimits::MAX_BUFFERED) {
+        close_connection(fd);
+        return;
+    }
+    if (connection.read_closed && !connection.busy && connection.in.empty() && connection.out.empty()) {
+        close_connection(fd);
+        return;
+    }
+    // only ask for EPOLLOUT while there's something waiting, otherwise it fires constantly.
+    // EPOLLIN is off while a command is in flight, the socket buffer holds the client back
+    // until then, and once the client has shut down its side
+    epoll_event event = {};
+    if (!connection.read_closed && !connection.busy) {
+        event.events |= EPOLLIN;
+    }
+    if (!connection.out.empty()) {
+        event.events |= EPOLLOUT;
+    }
+    event.data.fd = fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event);
+}
+
+void GameServer::close_connection(int fd) {
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    connections.erase(fd);
+}
+
+void GameServer::collect_answers() {
+    uint64_t count;
+    [[maybe_unused]] auto got = read(wake_fd, &count, sizeof(count));
+
+    std::vector<std::tuple<int, uint64_t, std::string>> ready;
+    {
+        std::lock_guard<std::mutex> lock(answers_mutex);
+        ready.swap(answers);
+    }
+    for (auto &[fd, serial, line] : ready) {
+        // the connection may have closed, and its fd been reused, while the shard was busy
+        auto it = connections.find(fd);
+        if (it == connections.end() || it->second.serial != serial) {
+            continue;
+        }
+        it->second.out += line + "\n";
+        it->second.busy = false;
+        dispatch(fd);
+    }
+}
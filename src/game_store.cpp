@@ -0,0 +1,171 @@
+#include "game_store.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#include "zobrist.h"
+
+GameWriter::GameWriter(std::string path) {
+    file = std::fopen(path.c_str(), "ab");
+    if (!file) {
+        return;
+    }
+    // "ab" always starts at the end, so an empty file is a new one
+    std::fseek(file, 0, SEEK_END);
+    if (std::ftell(file) == 0) {
+        uint32_t version = GameStore::VERSION;
+        std::fwrite(GameStore::MAGIC, 1, 4, file);
+        std::fwrite(&version, sizeof(version), 1, file);
+    }
+}
+
+GameWriter::~GameWriter() {
+    if (file) {
+        std::fclose(file);
+    }
+}
+
+bool GameWriter::append(GameHeader header, std::vector<Move> *moves) {
+    if (!file || moves->size() > UINT16_MAX) {
+        return false;
+    }
+    header.ply_count = (uint16_t)moves->size();
+    if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+        return false;
+    }
+    return std::fwrite(moves->data(), sizeof(Move), moves->size(), file) == moves->size();
+}
+
+GameReader::GameReader(std::string path) : file(path) {
+    if (!file.is_open() || file.size() < GameStore::FILE_HEADER_SIZE) {
+        return;
+    }
+    uint32_t version;
+    std::memcpy(&version, file.data() + 4, sizeof(version));
+    if (std::memcmp(file.data(), GameStore::MAGIC, 4) != 0 || version != GameStore::VERSION) {
+        return;
+    }
+
+    // Hop from header to header, a truncated last game (crash while appending) is ignored
+    uint64_t offset = GameStore::FILE_HEADER_SIZE;
+    while (offset + sizeof(GameHeader) <= file.size()) {
+        GameHeader header;
+        std::memcpy(&header, file.data() + offset, sizeof(header));
+        uint64_t end = offset + sizeof(GameHeader) + header.ply_count * sizeof(Move);
+        if (end > file.size()) {
+            break;
+        }
+        offsets.push_back(offset);
+        offset = end;
+    }
+    valid = true;
+}
+
+GameHeader GameReader::header(uint32_t game_id) {
+    GameHeader header;
+    std::memcpy(&header, file.data() + offsets[game_id], sizeof(header));
+    return header;
+}
+
+std::span<const Move> GameReader::moves(uint32_t game_id) {
+    // every record is an even number of bytes, so moves are always 2 byte aligned
+    const Move *first = (const Move *)(file.data() + offsets[game_id] + sizeof(GameHeader));
+    return std::span<const Move>(first, header(game_id).ply_count);
+}
+
+namespace {
+    bool entry_less(const PositionIndexEntry &lhs, const PositionIndexEntry &rhs) {
+        if (lhs.key != rhs.key) {
+            return lhs.key < rhs.key;
+        }
+        if (lhs.game_id != rhs.game_id) {
+            return lhs.game_id < rhs.game_id;
+        }
+        return lhs.ply < rhs.ply;
+    }
+
+    void index_games(GameReader *games, uint32_t first, uint32_t last, std::vector<PositionIndexEntry> *entries) {
+        for (uint32_t game_id = first; game_id < last; game_id++) {
+            auto pieces = init_pieces(player.color);
+            uint64_t key = hash_position(&pieces, Piece::White);
+            entries->push_back({key, game_id, 0, 0});
+
+            uint16_t ply = 0;
+            for (Move move : games->moves(game_id)) {
+                Position from = move_from(move);
+                Position to = move_to(move);
+                key = hash_after_move(key, &pieces, from, to);
+                move_piece(&pieces, from, to);
+                entries->push_back({key, game_id, ++ply, 0});
+            }
+        }
+        std::sort(entries->begin(), entries->end(), entry_less);
+    }
+}  // namespace
+
+bool build_position_index(GameReader *games, std::string path, int thread_count) {
+    if (thread_count <= 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    uint32_t game_count = games->game_count();
+    thread_count = std::min<int>(thread_count, std::max<uint32_t>(game_count, 1));
+
+    // Each thread indexes and sorts a contiguous range of games
+    std::vector<std::vector<PositionIndexEntry>> parts(thread_count);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < thread_count; i++) {
+        uint32_t first = (uint64_t)game_count * i / thread_count;
+        uint32_t last = (uint64_t)game_count * (i + 1) / thread_count;
+        threads.emplace_back(index_games, games, first, last, &parts[i]);
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    // then the sorted parts are merged
+    std::vector<PositionIndexEntry> entries;
+    for (auto &part : parts) {
+        size_t middle = entries.size();
+        entries.insert(entries.end(), part.begin(), part.end());
+        std::inplace_merge(entries.begin(), entries.begin() + middle, entries.end(), entry_less);
+        part = {};
+    }
+
+    FILE *file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    uint32_t version = PositionIndexFile::VERSION;
+    uint64_t count = entries.size();
+    bool ok = std::fwrite(PositionIndexFile::MAGIC, 1, 4, file) == 4;
+    ok = ok && std::fwrite(&version, sizeof(version), 1, file) == 1;
+    ok = ok && std::fwrite(&count, sizeof(count), 1, file) == 1;
+    ok = ok && std::fwrite(entries.data(), sizeof(PositionIndexEntry), entries.size(), file) == entries.size();
+    return (std::fclose(file) == 0) && ok;
+}
+
+PositionIndex::PositionIndex(std::string path) : file(path) {
+    if (!file.is_open() || file.size() < PositionIndexFile::FILE_HEADER_SIZE) {
+        return;
+    }
+    uint32_t version;
+    std::memcpy(&version, file.data() + 4, sizeof(version));
+    if (std::memcmp(file.data(), PositionIndexFile::MAGIC, 4) != 0 || version != PositionIndexFile::VERSION) {
+        return;
+    }
+    uint64_t count;
+    std::memcpy(&count, file.data() + 8, sizeof(count));
+    // divided rather than multiplied, a corrupt count would overflow
+    if (count > (file.size() - PositionIndexFile::FILE_HEADER_SIZE) / sizeof(PositionIndexEntry)) {
+        return;
+    }
+    entries = std::span<const PositionIndexEntry>((const PositionIndexEntry *)(file.data() + PositionIndexFile::FILE_HEADER_SIZE), count);
+    valid = true;
+}
+
+std::span<const PositionIndexEntry> PositionIndex::find(uint64_t key) {
+    auto first = std::lower_bound(entries.begin(), entries.end(), key, [](const PositionIndexEntry &entry, uint64_t k) { return entry.key < k; });
+    auto last = std::upper_bound(first, entries.end(), key, [](uint64_t k, const PositionIndexEntry &entry) { return k < entry.key; });
+    return std::span<const PositionIndexEntry>(first, last);
+}
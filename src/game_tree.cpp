@@ -0,0 +1,124 @@
+#include "game_tree.h"
+
+#include <algorithm>
+
+GameTree::GameTree() {
+    nodes.reserve(1024);
+    nodes.push_back(GameNode{0, Piece::None, 0, GameTreeNode::NONE, GameTreeNode::NONE, GameTreeNode::NONE, GameTreeNode::NONE});
+}
+
+void GameTree::enter(std::array<std::array<int, 8>, 8> *pieces, uint32_t child) {
+    Position to = move_to(nodes[child].move);
+    nodes[child].captured = (*pieces)[to.x][to.y];
+    move_piece(pieces, move_from(nodes[child].move), to);
+    nodes[node].selected_child = child;
+    node = child;
+    depth++;
+}
+
+void GameTree::play(std::array<std::array<int, 8>, 8> *pieces, Move move) {
+    // a move we already have is just a redo
+    uint32_t last = GameTreeNode::NONE;
+    for (uint32_t child = nodes[node].first_child; child != GameTreeNode::NONE; child = nodes[child].next_sibling) {
+        if (nodes[child].move == move) {
+            enter(pieces, child);
+            return;
+        }
+        last = child;
+    }
+
+    uint32_t child = nodes.size();
+    nodes.push_back(GameNode{move, Piece::None, 0, node, GameTreeNode::NONE, GameTreeNode::NONE, GameTreeNode::NONE});
+    if (last == GameTreeNode::NONE) {
+        nodes[node].first_child = child;
+    } else {
+        nodes[last].next_sibling = child;
+    }
+    enter(pieces, child);
+}
+
+bool GameTree::back(std::array<std::array<int, 8>, 8> *pieces) {
+    if (node == GameTreeNode::ROOT) {
+        return false;
+    }
+    GameNode &current = nodes[node];
+    Position from = move_from(current.move);
+    Position to = move_to(current.move);
+    move_piece(pieces, to, from);
+    (*pieces)[to.x][to.y] = current.captured;
+
+    node = current.parent;
+    depth--;
+    return true;
+}
+
+bool GameTree::forward(std::array<std::array<int, 8>, 8> *pieces) {
+    uint32_t child = nodes[node].selected_child;
+    if (child == GameTreeNode::NONE) {
+        child = nodes[node].first_child;
+    }
+    if (child == GameTreeNode::NONE) {
+        return false;
+    }
+    enter(pieces, child);
+    return true;
+}
+
+bool GameTree::next_variation(std::array<std::array<int, 8>, 8> *pieces) {
+    if (node == GameTreeNode::ROOT || nodes[node].next_sibling == GameTreeNode::NONE) {
+        return false;
+    }
+    uint32_t sibling = nodes[node].next_sibling;
+    back(pieces);
+    enter(pieces, sibling);
+    return true;
+}
+
+bool GameTree::previous_variation(std::array<std::array<int, 8>, 8> *pieces) {
+    if (node == GameTreeNode::ROOT) {
+        return false;
+    }
+    uint32_t previous = GameTreeNode::NONE;
+    for (uint32_t child = nodes[nodes[node].parent].first_child; child != node; child = nodes[child].next_sibling) {
+        previous = child;
+    }
+    if (previous == GameTreeNode::NONE) {
+        return false;
+    }
+    back(pieces);
+    enter(pieces, previous);
+    return true;
+}
+
+void GameTree::jump_to_ply(std::array<std::array<int, 8>, 8> *pieces, int target) {
+    while (depth > target && back(pieces)) {
+    }
+    while (depth < target && forward(pieces)) {
+    }
+}
+
+void GameTree::jump_to_node(std::array<std::array<int, 8>, 8> *pieces, uint32_t target) {
+    // path from target up to the root
+    std::vector<uint32_t> path;
+    for (uint32_t i = target; i != GameTreeNode::NONE; i = nodes[i].parent) {
+        path.push_back(i);
+    }
+    // back up until we're on it, then walk down
+    while (std::find(path.begin(), path.end(), node) == path.end()) {
+        back(pieces);
+    }
+    auto it = std::find(path.begin(), path.end(), node);
+    while (it != path.begin()) {
+        --it;
+        enter(pieces, *it);
+    }
+}
+
+std::vector<Move> GameTree::line() {
+    std::vector<Move> result;
+    for (uint32_t i = node; i != GameTreeNode::ROOT; i = nodes[i].parent) {
+        result.push_back(nodes[i].move);
+    }
+    std::reverse(result.begin(), result.end());
+    return result;
+}
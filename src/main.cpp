@@ -1,115 +1,36 @@
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <format>
+#include <thread>
 #include <tuple>
 #include <vector>
 
+#include "bitbase.h"
+#include "board.h"
+#include "book.h"
+#include "game_tree.h"
+#include "mate_solver.h"
+#include "pgn.h"
 #include "raylib.h"
+#include "render.h"
+#include "trace.h"
+#include "zobrist.h"
 
 namespace Constants {
-    inline const int SQUARE_LENGTH = 48;
-    inline const Color SQUARE_LIGHT = Color{235, 236, 208, 255};
-    inline const Color SQUARE_DARK = Color{119, 149, 86, 255};
-    inline const Color SQUARE_SELECTED = Color{66, 81, 49, 255};
-    inline const Color TRANSPARENT = Color{0, 0, 0, 0};
+    inline const int MATE_IN = 3;
+    inline const int MATE_MAX_NODES = 100000;
 }  // namespace Constants
 
-typedef struct Position {
-    int x;
-    int y;
-} Position;
-bool operator==(const Position &lhs, const Position &rhs) { return (lhs.x == rhs.x) && (lhs.y == rhs.y); }
-
-// namespace Moves {
-//     inline const std::array<int, 2> Queen = {2, 2};
-// }
-
-enum class Direction { North, East, South, West, NorthEast, SouthEast, SouthWest, NorthWest };
-
-namespace Directions {
-    std::vector<Direction> Queen = {Direction::North, Direction::East, Direction::South, Direction::West, Direction::NorthEast, Direction::SouthEast, Direction::SouthWest, Direction::NorthWest};
-    std::vector<Direction> Bishop = {Direction::NorthEast, Direction::SouthEast, Direction::SouthWest, Direction::NorthWest};
-    std::vector<Direction> Rook = {Direction::North, Direction::East, Direction::South, Direction::West};
-}  // namespace Directions
-
-struct Piece {
-    static const int None = 0b00000;    // 0
-    static const int Pawn = 0b00001;    // 1
-    static const int Knight = 0b00011;  // 2
-    static const int Bishop = 0b00100;  // 3
-    static const int Rook = 0b00101;    // 4
-    static const int Queen = 0b00110;   // 5
-    static const int King = 0b00111;    // 6
-
-    static const int Black = 0b01000;  // 8
-    static const int White = 0b10000;  // 16
-};
-
-struct Square {
-    // static const int None = 0;
-    static const int Selected = 0b00001;  // 1
-    static const int Indicator = 0b0010;  // 2
-                                          //
-    static const int Dark = 0b01000;      // 8
-    static const int Light = 0b10000;     // 16
-};
-
-class Player {
-   public:
-    const int color;
-    int homeColumn;
-    int number_of_moves;
-    Player(int clr) : color(clr) {
-        if (clr == Piece::Black) {
-            homeColumn = 1;
-        } else {
-            homeColumn = 6;
-        }
-    };
-};
-
-Player player = Player(Piece::Black);
-
 void debug(std::string s) { TraceLog(LOG_INFO, s.c_str()); }
 
 // bool has_flag(int a, int b) { return (a & b) == b; }
 
-int piece_type(int a) { return a & 0b00111; }
-
-// the only reason these are the same is because i used both 8,16 as flags for pieces and squares. the bit masks would have to be different if different numbers
-int piece_color(int a) { return a & 0b11000; }
-int square_color(int a) { return a & 0b11000; }
-
-bool square_is_selected(int a) { return (a & Square::Selected) == Square::Selected; }
-bool square_is_indicator(int a) { return (a & Square::Indicator) == Square::Indicator; }
-
-int opposite_color(int color) {
-    switch (color) {
-        case Piece::Black:
-            return Piece::White;
-            break;
-        case Piece::White:
-            return Piece::Black;
-            break;
-    }
-    return 0;
-}
-
 bool within_rectangle(Vector2 mouse_position, Rectangle r) {
     //
     return (mouse_position.x >= (r.x)) && (mouse_position.x <= (r.x + r.width)) && (mouse_position.y >= r.y) && (mouse_position.y <= (r.y + r.width));
 }
 
-Rectangle rectangle_from_x_y(int x, int y) {
-    // TODO: bounds checking
-    return Rectangle{
-        (float)x * Constants::SQUARE_LENGTH,
-        (float)(7 - y) * Constants::SQUARE_LENGTH,
-        Constants::SQUARE_LENGTH,
-        Constants::SQUARE_LENGTH,
-    };
-};
-
 Position position_from_mouse_position(Vector2 mouse_position) {
     // auto x = ((int)trunc(mouse_position.x) - Board::OFFSET) / LENGTH;
     // auto y = ((int)trunc(mouse_position.y) - Board::OFFSET) / LENGTH;
@@ -119,486 +40,6 @@ Position position_from_mouse_position(Vector2 mouse_position) {
     return Position{row, col};
 }
 
-// int transpose(std::array<std::array<int, 8>, 8> *pieces, Vector2 initial_position, int drow, int dcol) {
-//     int piece = (*pieces)[initial_position.x][initial_position.y];
-//     int y;
-//     switch (piece_color(piece)) {
-//         case Piece::Black:
-//             y = dcol;
-//             break;
-//         case Piece::White:
-//             y = -dcol;
-//             break;
-//     }
-//
-//     return (*pieces)[initial_position.x + drow][initial_position.y + y];
-// }
-
-// TODO: pick one of them
-// Vector2 transpose(std::array<std::array<int, 8>, 8> *pieces, Vector2 initial_position, int drow, int dcol) {
-//     int piece = (*pieces)[initial_position.x][initial_position.y];
-//     Vector2 final;
-//
-//     switch (piece_color(piece)) {
-//         case Piece::Black:
-//             final = {initial_position.x + drow, initial_position.y + dcol};
-//             break;
-//         case Piece::White:
-//             final = {initial_position.x + drow, initial_position.y - dcol};
-//             break;
-//     }
-//     return final;
-// }
-
-int forward(int color, int col, int dcol) {
-    if (color == player.color) {
-        return col + dcol;
-    } else {
-        return col - dcol;
-    }
-    // switch (color) {
-    //     case Piece::Black:
-    //         return col + dcol;
-    //         break;
-    //     case Piece::White:
-    //         return col - dcol;
-    //         break;
-    // }
-    return 0;
-}
-
-std::tuple<int, Texture2D> load_piece_texture(int piece) {
-    std::string filename = "assets/pieces/";
-
-    // Color
-    if (piece & Piece::Black) {
-        filename.append("b");
-    } else if (piece & Piece::White) {
-        filename.append("w");
-    }
-
-    if (piece_type(piece) == Piece::Queen) {
-        filename.append("Q");
-    } else if (piece_type(piece) == Piece::Bishop) {
-        filename.append("B");
-    } else if (piece_type(piece) == Piece::Pawn) {
-        filename.append("P");
-    } else if (piece_type(piece) == Piece::King) {
-        filename.append("K");
-    } else if (piece_type(piece) == Piece::Knight) {
-        filename.append("N");
-    } else if (piece_type(piece) == Piece::Rook) {
-        filename.append("R");
-    }
-
-    filename.append(".png");
-
-    return std::make_tuple(piece, LoadTexture(filename.c_str()));
-}
-
-std::vector<std::tuple<int, Texture2D>> load_textures(std::array<std::array<int, 8>, 8> *pieces) {
-    std::vector<std::tuple<int, Texture2D>> all_textures;
-    for (int row = 0; row < 8; row++) {
-        for (int column = 0; column < 8; column++) {
-            int piece = (*pieces)[row][column];
-            if (piece) {
-                all_textures.emplace_back(load_piece_texture(piece));
-            }
-        }
-    }
-    return all_textures;
-}
-
-void unload_textures(std::vector<std::tuple<int, Texture2D>> *piece_textures) {
-    for (const auto &[key, value] : (*piece_textures)) {
-        UnloadTexture(value);
-    }
-}
-
-std::vector<Position> get_positions_in_directions(std::array<std::array<int, 8>, 8> *pieces, Position starting_position, std::vector<Direction> directions) {
-    //
-    int starting_row = starting_position.x;
-    int starting_column = starting_position.y;
-    int starting_piece = (*pieces)[starting_row][starting_column];
-
-    std::vector<Position> result;
-    for (auto &direction : directions) {
-        Position temp_pos = Position{starting_row, starting_column};
-        // debug(std::format("Bee  {}", temp_pos.y));
-        switch (direction) {
-            case (Direction::North):
-                while (temp_pos.y < 7) {
-                    temp_pos.y++;
-                    int p = (*pieces)[starting_row][temp_pos.y];
-                    if (p) {
-                        if (piece_color(p) != piece_color(starting_piece)) {
-                            result.push_back({starting_row, temp_pos.y});
-                        }
-                        break;
-                    }
-                    result.push_back({starting_row, temp_pos.y});
-                }
-                break;
-            case (Direction::East):
-                while (temp_pos.x < 7) {
-                    temp_pos.x++;
-                    int p = (*pieces)[temp_pos.x][starting_column];
-                    if (p) {
-                        if (piece_color(p) != piece_color(starting_piece)) {
-                            result.push_back({temp_pos.x, starting_column});
-                        }
-                        break;
-                    }
-                    result.push_back({temp_pos.x, starting_column});
-                }
-
-                break;
-            case (Direction::South):
-                while (temp_pos.y > 0) {
-                    temp_pos.y--;
-                    int p = (*pieces)[starting_row][temp_pos.y];
-                    if (p) {
-                        if (piece_color(p) != piece_color(starting_piece)) {
-                            result.push_back({starting_row, temp_pos.y});
-                        }
-                        break;
-                    }
-                    result.push_back({starting_row, temp_pos.y});
-                    // debug(std::format("{}", temp_pos.y));
-                }
-
-                break;
-            case (Direction::West):
-                while (temp_pos.x > 0) {
-                    temp_pos.x--;
-                    int p = (*pieces)[temp_pos.x][starting_column];
-                    if (p) {
-                        if (piece_color(p) != piece_color(starting_piece)) {
-                            result.push_back({temp_pos.x, starting_column});
-                        }
-                        break;
-                    }
-                    result.push_back({temp_pos.x, starting_column});
-                    // debug(std::format("{}", temp_pos.y));
-                }
-                break;
-            case (Direction::NorthEast):
-                while (temp_pos.y < 7 && temp_pos.x < 7) {
-                    temp_pos.x++;
-                    temp_pos.y++;
-                    int p = (*pieces)[temp_pos.x][temp_pos.y];
-                    if (p) {
-                        if (piece_color(p) != piece_color(starting_piece)) {
-                            result.push_back({temp_pos.x, temp_pos.y});
-                        }
-                        break;
-                    }
-                    result.push_back({temp_pos.x, temp_pos.y});
-                    // debug(std::format("{}", temp_pos.y));
-                }
-                break;
-            case (Direction::SouthEast):
-                while (temp_pos.y > 0 && temp_pos.x < 7) {
-                    temp_pos.x++;
-                    temp_pos.y--;
-                    int p = (*pieces)[temp_pos.x][temp_pos.y];
-                    if (p) {
-                        if (piece_color(p) != piece_color(starting_piece)) {
-                            result.push_back({temp_pos.x, temp_pos.y});
-                        }
-                        break;
-                    }
-                    result.push_back({temp_pos.x, temp_pos.y});
-                }
-                break;
-            case (Direction::SouthWest):
-                while (temp_pos.y > 0 && temp_pos.x > 0) {
-                    temp_pos.x--;
-                    temp_pos.y--;
-                    int p = (*pieces)[temp_pos.x][temp_pos.y];
-                    if (p) {
-                        if (piece_color(p) != piece_color(starting_piece)) {
-                            result.push_back({temp_pos.x, temp_pos.y});
-                        }
-                        break;
-                    }
-
-                    result.push_back({temp_pos.x, temp_pos.y});
-                }
-                break;
-            case (Direction::NorthWest):
-                while (temp_pos.y < 7 && temp_pos.x > 0) {
-                    temp_pos.x--;
-                    temp_pos.y++;
-                    int p = (*pieces)[temp_pos.x][temp_pos.y];
-                    if (p) {
-                        if (piece_color(p) != piece_color(starting_piece)) {
-                            result.push_back({temp_pos.x, temp_pos.y});
-                        }
-                        break;
-                    }
-                    result.push_back({temp_pos.x, temp_pos.y});
-                }
-                break;
-        }
-    }
-
-    return result;
-}
-
-bool position_is_within_board(Position position) {
-    //
-    return ((position.x >= 0) && (position.x <= 7) && (position.y >= 0) && (position.y <= 7));
-}
-
-/* Generic function for any piece */
-bool is_valid_primative_move(std::array<std::array<int, 8>, 8> *pieces, Position start_pos, Position end_pos) {
-    int starting_piece = (*pieces)[start_pos.x][start_pos.y];
-    int ending_piece = (*pieces)[end_pos.x][end_pos.y];
-
-    // No Pieces can move outside the board
-    if (!position_is_within_board(end_pos)) {
-        return false;
-    }
-
-    // If we are moving nothing, it's not valid
-    if (!starting_piece) {
-        return false;
-    }
-    // No 2 Pieces can occupy same position
-    if (starting_piece && ending_piece) {
-        if (piece_color(starting_piece) == piece_color(ending_piece)) {
-            return false;
-        }
-    }
-    return true;
-}
-
-std::vector<Position> get_primative_knight_positions(std::array<std::array<int, 8>, 8> *pieces, int x, int y) {
-    std::vector<Position> result;
-
-    std::array<Position, 8> candidates = {{
-        // top
-        {x - 2, y + 1},
-        {x - 1, y + 2},
-        {x + 1, y + 2},
-        {x + 2, y + 1},
-        // bottom
-        {x - 2, y - 1},
-        {x - 1, y - 2},
-        {x + 1, y - 2},
-        {x + 2, y - 1},
-    }};
-    for (const auto &[a, b] : candidates) {
-        if (is_valid_primative_move(pieces, Position{x, y}, Position{a, b})) {
-            result.push_back({a, b});
-        };
-    }
-    return result;
-}
-
-std::vector<Position> get_primative_king_positions(std::array<std::array<int, 8>, 8> *pieces, int x, int y) {
-    std::vector<Position> result;
-
-    std::array<Position, 8> candidates = {{
-        // top
-        {x - 1, y + 1},
-        {x, y + 1},
-        {x + 1, y + 1},
-        //  >:3
-        {x - 1, y},
-        {x + 1, y},
-        // bottom (you)
-        {x - 1, y - 1},
-        {x, y - 1},
-        {x + 1, y - 1},
-    }};
-    for (const auto &[a, b] : candidates) {
-        if (is_valid_primative_move(pieces, Position{x, y}, Position{a, b})) {
-            result.push_back({a, b});
-        };
-    }
-
-    // TODO: Casting O-O and O-O-O
-    return result;
-}
-
-std::vector<Position> get_primative_pawn_positions(std::array<std::array<int, 8>, 8> *pieces, int x, int y) {
-    std::vector<Position> result;
-
-    int piece = (*pieces)[x][y];
-    int color = piece_color(piece);
-
-    Position inital_position = Position{x, y};
-    Position possible_position;
-
-    // Not eating
-    possible_position = Position{x, forward(color, y, 1)};
-    if (is_valid_primative_move(pieces, inital_position, possible_position)) {
-        // If theres nobody 1 squares forward from me
-        if ((*pieces)[possible_position.x][possible_position.y] == Piece::None) {
-            // i can move up one
-            result.push_back(possible_position);
-
-            // additionally, if im on the second column
-            if ((y == 1 && color == player.color) || (y == 6 && color == opposite_color(player.color))) {
-                possible_position = Position{x, forward(color, y, 2)};
-                if (is_valid_primative_move(pieces, inital_position, possible_position)) {
-                    // and theres nobody 2 squares forward from me
-                    if ((*pieces)[possible_position.x][possible_position.y] == Piece::None) {
-                        // i can move up two
-                        result.push_back(possible_position);
-                    }
-                }
-            }
-        }
-    }
-
-    // Eating
-    possible_position = Position{x - 1, forward(color, y, 1)};  // top left
-    if (is_valid_primative_move(pieces, inital_position, possible_position)) {
-        // If theres a piece in top left of me
-        auto top_left_piece = (*pieces)[possible_position.x][possible_position.y];
-        if (top_left_piece) {
-            // If the piece in front has opposite color of me
-            if (color != piece_color(top_left_piece)) {
-                // i can eat it
-                result.push_back(possible_position);
-            }
-        }
-    }
-
-    possible_position = Position{x + 1, forward(color, y, 1)};  // top right
-    if (is_valid_primative_move(pieces, inital_position, possible_position)) {
-        // If theres a piece in top right of me
-        auto top_left_piece = (*pieces)[possible_position.x][possible_position.y];
-        if (top_left_piece) {
-            // If the piece in front has opposite color of me
-            if (color != piece_color(top_left_piece)) {
-                // i can eat it
-                result.push_back(possible_position);
-            }
-        }
-    }
-
-    // TODO: En passant
-
-    return result;
-}
-
-std::vector<Position> get_primative_positions(std::array<std::array<int, 8>, 8> *pieces, int x, int y) {
-    std::vector<Position> result;
-
-    int starting_piece = (*pieces)[x][y];
-
-    std::vector<Direction> directions;
-    switch (piece_type(starting_piece)) {
-        // case Piece::Pawn:
-        // case Piece::Knight:
-        case (Piece::Bishop):
-            directions = Directions::Bishop;
-            break;
-        case (Piece::Rook):
-            directions = Directions::Rook;
-            break;
-        case (Piece::Queen):
-            directions = Directions::Queen;
-            break;
-            // case Piece::King:
-    }
-    if (!directions.empty()) {
-        auto positions = get_positions_in_directions(pieces, Position{x, y}, directions);
-        result.insert(result.end(), positions.begin(), positions.end());
-        return result;
-    }
-
-    if (piece_type(starting_piece) == Piece::Pawn) {
-        auto positions = get_primative_pawn_positions(pieces, x, y);
-        result.insert(result.end(), positions.begin(), positions.end());
-    } else if (piece_type(starting_piece) == Piece::Knight) {
-        auto positions = get_primative_knight_positions(pieces, x, y);
-        result.insert(result.end(), positions.begin(), positions.end());
-    } else if (piece_type(starting_piece) == Piece::King) {
-        auto positions = get_primative_king_positions(pieces, x, y);
-        result.insert(result.end(), positions.begin(), positions.end());
-    }
-
-    // debug(std::format("finaly result {}", result));
-    return result;
-}
-
-std::vector<Position> get_attacking_positions(std::array<std::array<int, 8>, 8> *pieces, int x, int y) {
-    // TODO: pawn moving forward is primative but not attacking
-    return get_primative_positions(pieces, x, y);
-}
-
-std::vector<Position> get_all_attacking_positions(int color, std::array<std::array<int, 8>, 8> *pieces) {
-    std::vector<Position> result;
-    for (int x = 0; x < 8; x++) {
-        for (int y = 0; y < 8; y++) {
-            int piece = (*pieces)[x][y];
-            if (piece) {
-                if (piece_color(piece) == color) {
-                    auto attacking_positions = get_attacking_positions(pieces, x, y);
-                    result.insert(result.end(), attacking_positions.begin(), attacking_positions.end());
-                }
-            }
-        }
-    }
-
-    return result;
-}
-
-bool is_under_attack(int color, std::array<std::array<int, 8>, 8> *pieces) {
-    std::vector<Position> all_attacking_positions;
-
-    all_attacking_positions = get_all_attacking_positions(opposite_color(color), pieces);
-
-    // debug(std::format("000000"));
-    for (auto &[a, b] : all_attacking_positions) {
-        // debug(std::format("attacking positions {} {}", x, y));
-        if (piece_type((*pieces)[a][b]) == Piece::King && (piece_color((*pieces)[a][b]) == color)) {
-            return true;
-        }
-    }
-    return false;
-};
-
-void move_piece(std::array<std::array<int, 8>, 8> *pieces, Position initial, Position final) {
-    (*pieces)[final.x][final.y] = (*pieces)[initial.x][initial.y];
-    if (initial != final) {
-        (*pieces)[initial.x][initial.y] = Piece::None;
-    }
-}
-
-std::vector<Position> get_valid_positions(std::array<std::array<int, 8>, 8> *pieces, int x, int y) {
-    //
-    std::vector<Position> result;
-
-    auto primative_positions = get_primative_positions(pieces, x, y);
-    for (auto &[a, b] : primative_positions) {
-        auto cloned_pieces = (*pieces);              // cloned_pieces contains a clone of pieces
-        move_piece(&cloned_pieces, {x, y}, {a, b});  // thats why we can modify without affecting our real board
-
-        // If i make this move and im not under attack after moving, then im safe to do so
-        if (!is_under_attack(piece_color((*pieces)[x][y]), &cloned_pieces)) {
-            // white to move
-            if (player.number_of_moves % 2 == 0) {
-                if (piece_color((*pieces)[x][y]) == Piece::White) {
-                    result.push_back({a, b});
-                }
-
-            } else {  // black to move
-                if (piece_color((*pieces)[x][y]) == Piece::Black) {
-                    result.push_back({a, b});
-                }
-            }
-            // result.push_back({a, b});
-        }
-    }
-    return result;
-}
-
 void update_squares(std::array<std::array<int, 8>, 8> *squares) {}
 
 void update_pieces(std::array<std::array<int, 8>, 8> *pieces) {}
@@ -647,7 +88,7 @@ void update_pieces(std::array<std::array<int, 8>, 8> *pieces) {}
 Vector2 prev_mouse_pos = {0, 0};
 // bool should_draw_squares_now = false;
 
-void update_board(std::array<std::array<int, 8>, 8> *squares, std::array<std::array<int, 8>, 8> *pieces) {
+void update_board(std::array<std::array<int, 8>, 8> *squares, std::array<std::array<int, 8>, 8> *pieces, GameTree *game_tree) {
     Vector2 mouse_position = GetMousePosition();
     Rectangle board_rect = Rectangle{0, 0, Constants::SQUARE_LENGTH * 8, Constants::SQUARE_LENGTH * 8};
 
@@ -682,8 +123,8 @@ void update_board(std::array<std::array<int, 8>, 8> *squares, std::array<std::ar
                 } else {
                     if (!prev_valid_positions.empty()) {
                         if (std::find(prev_valid_positions.begin(), prev_valid_positions.end(), current_position) != prev_valid_positions.end()) {
-                            move_piece(pieces, prev_position, current_position);
-                            player.number_of_moves++;
+                            game_tree->play(pieces, encode_move(prev_position, current_position));
+                            player.number_of_moves = game_tree->ply();
                         }
                     }
 
@@ -708,90 +149,185 @@ void update_board(std::array<std::array<int, 8>, 8> *squares, std::array<std::ar
     }
 }
 
-void draw_piece_texture(Texture2D piece_texture, Rectangle dest_rect) {}
-void draw_piece_texture(Texture2D piece_texture, int x, int y) {
-    Rectangle dest_rect = rectangle_from_x_y(x, y);
-    DrawTexturePro(piece_texture, Rectangle{0, 0, (float)piece_texture.width, (float)piece_texture.height}, dest_rect, Vector2{0, 0}, 0, RAYWHITE);
-}
+// Left/Right take back and redo, Up/Down switch to the other moves played here, Home/End jump to the ends of the line
+void update_history(GameTree *game_tree, std::array<std::array<int, 8>, 8> *squares, std::array<std::array<int, 8>, 8> *pieces) {
+    bool moved = false;
+    if (IsKeyPressed(KEY_LEFT)) {
+        moved = game_tree->back(pieces);
+    } else if (IsKeyPressed(KEY_RIGHT)) {
+        moved = game_tree->forward(pieces);
+    } else if (IsKeyPressed(KEY_UP)) {
+        moved = game_tree->previous_variation(pieces);
+    } else if (IsKeyPressed(KEY_DOWN)) {
+        moved = game_tree->next_variation(pieces);
+    } else if (IsKeyPressed(KEY_HOME)) {
+        moved = game_tree->ply() != 0;
+        game_tree->jump_to_ply(pieces, 0);
+    } else if (IsKeyPressed(KEY_END)) {
+        int ply = game_tree->ply();
+        game_tree->jump_to_ply(pieces, INT32_MAX);
+        moved = game_tree->ply() != ply;
+    }
+    if (!moved) {
+        return;
+    }
+    player.number_of_moves = game_tree->ply();
 
-void draw_pieces(std::array<std::array<int, 8>, 8> *pieces, std::vector<std::tuple<int, Texture2D>> *piece_textures) {
-    for (int row = 0; row < 8; row++) {
-        for (int column = 0; column < 8; column++) {
-            Rectangle dest_rect = rectangle_from_x_y(row, column);
-
-            Texture2D piece_texture;
-            bool found = false;
-            for (const auto &[key, value] : (*piece_textures)) {
-                if (key == (*pieces)[row][column]) {
-                    found = true;
-                    piece_texture = value;
-                }
-            }
+    // whatever was selected belongs to the old position
+    *squares = init_squares();
+    prev_mouse_pos = {0, 0};
+}
 
-            if (found) {
-                draw_piece_texture(piece_texture, row, column);
-            }
+// Lines from -> to for every book move in the current position
+void draw_book_moves(Book *book, std::array<std::array<int, 8>, 8> *pieces) {
+    if (!book->is_open()) {
+        return;
+    }
+    int color = side_to_move(player.number_of_moves);
+    for (auto &entry : book->find(hash_position(pieces, color))) {
+        if (is_legal_move(pieces, color, entry.move)) {
+            draw_move_arrow(entry.move, Constants::BOOK_MOVE);
         }
     }
 }
 
-void draw_squares(std::array<std::array<int, 8>, 8> *squares) {
-    for (int row = 0; row < 8; row++) {
-        for (int column = 0; column < 8; column++) {
-            auto rect = rectangle_from_x_y(row, column);
-            int current_square = (*squares)[row][column];
-            if (square_color(current_square) == Square::Dark) {
-                DrawRectangle(rect.x, rect.y, rect.width, rect.height, Constants::SQUARE_DARK);
-            } else if (square_color(current_square) == Square::Light) {
-                DrawRectangle(rect.x, rect.y, rect.width, rect.height, Constants::SQUARE_LIGHT);
-            }
-            // if (has_flag((*squares)[row][column], Square::Selected)) {
-            if (square_is_selected(current_square)) {
-                DrawRectangle(rect.x, rect.y, rect.width, rect.height, Constants::SQUARE_SELECTED);
-            }
-            if (square_is_indicator(current_square)) {
-                int centerX = rect.x + 0.5 * rect.width;
-                int centerY = rect.y + 0.5 * rect.height;
-                int radius = 0.125 * rect.width;
-                DrawCircle(centerX, centerY, radius, Constants::SQUARE_SELECTED);
-            }
-        }
+// Perf overlay, F3 shows it and F2 writes chess_trace.json. Only has numbers in a -DCHESS_TRACE=ON build
+typedef struct PerfOverlay {
+    bool visible = false;
+    std::array<uint64_t, TraceCounter::Count> last_totals{};
+    std::array<uint64_t, TraceCounter::Count> per_frame{};
+} PerfOverlay;
+
+void update_perf_overlay(PerfOverlay *overlay) {
+    if (IsKeyPressed(KEY_F3)) {
+        overlay->visible = !overlay->visible;
+    }
+    if (IsKeyPressed(KEY_F2) && trace_write_chrome_json("chess_trace.json")) {
+        debug("wrote chess_trace.json");
     }
+#ifdef CHESS_TRACE
+    // counters are running totals, the overlay and the trace want them per frame
+    const char *names[TraceCounter::Count] = {"nodes_generated", "board_clones", "legality_checks"};
+    for (int counter = 0; counter < TraceCounter::Count; counter++) {
+        uint64_t total = trace_counter(counter);
+        overlay->per_frame[counter] = total - overlay->last_totals[counter];
+        overlay->last_totals[counter] = total;
+        trace_record_counter(names[counter], overlay->per_frame[counter]);
+    }
+#endif
 }
 
-std::array<std::array<int, 8>, 8> init_pieces(int color) {
-    std::array<std::array<int, 8>, 8> pieces;
-    for (int x = 0; x < 8; x++) {
-        for (int y = 0; y < 8; y++) {
-            pieces[x][y] = 0;
-        }
+void draw_perf_overlay(PerfOverlay *overlay) {
+    if (!overlay->visible) {
+        return;
+    }
+    std::vector<std::string> lines;
+#ifdef CHESS_TRACE
+    for (const char *name : {"frame", "update", "draw"}) {
+        auto durations = trace_recent(name, 120);
+        lines.push_back(std::format("{} p50 {:.2f} p95 {:.2f} p99 {:.2f} ms", name, trace_percentile(durations, 50) / 1e6, trace_percentile(durations, 95) / 1e6, trace_percentile(durations, 99) / 1e6));
+    }
+    lines.push_back(std::format("nodes {} clones {} checks {} /frame", overlay->per_frame[TraceCounter::NodesGenerated], overlay->per_frame[TraceCounter::BoardClones], overlay->per_frame[TraceCounter::LegalityChecks]));
+#else
+    lines.push_back(std::format("{} fps, build with -DCHESS_TRACE=ON for more", GetFPS()));
+#endif
+    int board_length = Constants::SQUARE_LENGTH * 8;
+    DrawRectangle(0, 0, board_length, 4 + 14 * lines.size(), Color{0, 0, 0, 180});
+    for (size_t i = 0; i < lines.size(); i++) {
+        DrawText(lines[i].c_str(), 4, 2 + 14 * i, 12, WHITE);
+    }
+}
+
+void draw_bitbase_result(int wdl) {
+    std::string text;
+    int color = side_to_move(player.number_of_moves);
+    if (wdl == Wdl::Draw) {
+        text = "Draw";
+    } else if (wdl == Wdl::Win) {
+        text = (color == Piece::White) ? "White wins" : "Black wins";
+    } else if (wdl == Wdl::Loss) {
+        text = (color == Piece::White) ? "Black wins" : "White wins";
+    } else {
+        return;
+    }
+    DrawText(text.c_str(), 4, 4, 16, BLACK);
+}
+
+// Mate solver overlay, toggled with M. Solves once per position since it can take a moment
+typedef struct MateOverlay {
+    bool visible = false;
+    uint64_t solved_key = 0;
+    MateResult result;
+    std::string text;
+
+    // solving takes up to a few seconds so it runs on its own thread and the window keeps drawing
+    std::thread worker;
+    std::atomic<bool> solving = false;
+    std::atomic<bool> cancel = false;
+    MateResult pending;
+    std::string pending_text;
+} MateOverlay;
+
+void solve_mate_overlay(MateOverlay *overlay, std::array<std::array<int, 8>, 8> pieces, int color) {
+    overlay->pending = solve_mate(&pieces, color, Constants::MATE_IN, Constants::MATE_MAX_NODES, &overlay->cancel);
+    if (overlay->pending.status == MateStatus::Proven) {
+        overlay->pending_text = std::format("Mate in {}: {}", (overlay->pending.line.size() + 1) / 2, line_to_san(&pieces, &overlay->pending.line));
+    } else if (overlay->pending.status == MateStatus::Disproven) {
+        overlay->pending_text = std::format("No mate in {}", Constants::MATE_IN);
+    } else {
+        overlay->pending_text = "Mate search gave up";
+    }
+    overlay->solving = false;
+}
+
+void stop_mate_overlay(MateOverlay *overlay) {
+    if (overlay->worker.joinable()) {
+        overlay->cancel = true;
+        overlay->worker.join();
+    }
+}
+
+void update_mate_overlay(MateOverlay *overlay, std::array<std::array<int, 8>, 8> *pieces) {
+    if (IsKeyPressed(KEY_M)) {
+        overlay->visible = !overlay->visible;
+        overlay->solved_key = 0;
     }
-    // Load Pawns //
-    for (int x = 0; x < 8; x++) {
-        pieces[x][1] = player.color | Piece::Pawn;
-        pieces[x][6] = opposite_color(player.color) | Piece::Pawn;
+    if (overlay->worker.joinable() && !overlay->solving) {
+        overlay->worker.join();
+        overlay->result = overlay->pending;
+        overlay->text = overlay->pending_text;
     }
-    // my pieces //
-    pieces[0][0] = player.color | Piece::Rook;
-    pieces[1][0] = player.color | Piece::Knight;
-    pieces[2][0] = player.color | Piece::Bishop;
-    pieces[3][0] = player.color | Piece::Queen;
-    pieces[4][0] = player.color | Piece::King;
-    pieces[5][0] = player.color | Piece::Bishop;
-    pieces[6][0] = player.color | Piece::Knight;
-    pieces[7][0] = player.color | Piece::Rook;
-
-    // opponents pieces //
-    pieces[0][7] = opposite_color(player.color) | Piece::Rook;
-    pieces[1][7] = opposite_color(player.color) | Piece::Knight;
-    pieces[2][7] = opposite_color(player.color) | Piece::Bishop;
-    pieces[3][7] = opposite_color(player.color) | Piece::Queen;
-    pieces[4][7] = opposite_color(player.color) | Piece::King;
-    pieces[5][7] = opposite_color(player.color) | Piece::Bishop;
-    pieces[6][7] = opposite_color(player.color) | Piece::Knight;
-    pieces[7][7] = opposite_color(player.color) | Piece::Rook;
-
-    return pieces;
+
+    // keyed on the position rather than the move count, going back and into another variation lands on the same count
+    uint64_t key = hash_position(pieces, side_to_move(player.number_of_moves));
+    if (overlay->solving && (!overlay->visible || overlay->solved_key != key)) {
+        // the answer is for a position that's gone, the next one starts once this has stopped
+        overlay->cancel = true;
+        overlay->solved_key = 0;
+        return;
+    }
+    if (!overlay->visible || overlay->solving || overlay->solved_key == key) {
+        return;
+    }
+    overlay->solved_key = key;
+
+    overlay->result = MateResult{};
+    overlay->text = "Solving...";
+    overlay->cancel = false;
+    overlay->solving = true;
+    overlay->worker = std::thread(solve_mate_overlay, overlay, *pieces, side_to_move(player.number_of_moves));
+}
+
+void draw_mate_overlay(MateOverlay *overlay) {
+    if (!overlay->visible) {
+        return;
+    }
+    if (!overlay->result.line.empty()) {
+        draw_move_arrow(overlay->result.line[0], Constants::MATE_MOVE);
+    }
+    int board_length = Constants::SQUARE_LENGTH * 8;
+    DrawRectangle(0, board_length - 24, board_length, 24, BLACK);
+    DrawText(overlay->text.c_str(), 4, board_length - 20, 16, WHITE);
 }
 
 int main(void) {
@@ -806,20 +342,23 @@ int main(void) {
     std::array<std::array<int, 8>, 8> pieces = init_pieces(player.color);
 
     // Squares are drawn the same regardless of what piece_color the player is playing;
-    std::array<std::array<int, 8>, 8> squares;
-    for (int row = 0; row < 8; row++) {
-        for (int column = 0; column < 8; column++) {
-            if ((row + column) % 2 == 0) {
-                squares[row][column] = Square::Light;
-            } else {
-                squares[row][column] = Square::Dark;
-            }
-        }
-    }
+    std::array<std::array<int, 8>, 8> squares = init_squares();
 
     // Load textures
     std::vector<std::tuple<int, Texture2D>> piece_textures = load_textures(&pieces);
 
+    // Opening book, optional. It's memory mapped so only the pages we look at get read
+    Book book = Book("assets/book.bin");
+
+    // KRK and KQK are compiled in
+    load_embedded_bitbases();
+
+    // Every move played, takebacks and variations included
+    GameTree game_tree;
+
+    MateOverlay mate_overlay;
+    PerfOverlay perf_overlay;
+
     // debug(std::format("{}", 0b0110 | 0b1000));
     // debug(std::format("AA {}", forward(1, 1)));
     // debug(std::format("{}", 0b0001));
@@ -834,12 +373,19 @@ int main(void) {
         // debug(std::format("{}", Piece::Rook | Piece::Black));
         // update_squares(&squares);
         // update_pieces(&pieces);
-        update_board(&squares, &pieces);
+        TRACE_SCOPE("frame");
+        {
+            TRACE_SCOPE("update");
+            update_board(&squares, &pieces, &game_tree);
+            update_history(&game_tree, &squares, &pieces);
+            update_mate_overlay(&mate_overlay, &pieces);
+        }
 
         // debug(std::format("NOM {}", player.number_of_moves));
         // Draw
         //----------------------------------------------------------------------------------
         BeginDrawing();
+        [[maybe_unused]] uint64_t draw_start = trace_now();
         ClearBackground(BLUE);
 
         //
@@ -848,37 +394,31 @@ int main(void) {
 
         draw_squares(&squares);
         draw_pieces(&pieces, &piece_textures);
+        draw_book_moves(&book, &pieces);
+        draw_mate_overlay(&mate_overlay);
 
         // DrawRectangle(0, 0, 100, 48, BLACK);
         // DrawText(std::format("{}", GetFPS()).c_str(), 0, 0, 24, RED);
 
-        bool white_cant_move_anywhere = true;
-        bool black_cant_move_anywhere = true;
-        for (int x = 0; x < 8; x++) {
-            for (int y = 0; y < 8; y++) {
-                int piece = (pieces)[x][y];
-                if (piece) {
-                    if (!get_valid_positions(&pieces, x, y).empty() && piece_color(piece) == Piece::White) {
-                        white_cant_move_anywhere = false;
-                    }
-                    if (!get_valid_positions(&pieces, x, y).empty() && piece_color(piece) == Piece::Black) {
-                        black_cant_move_anywhere = false;
-                    }
-                }
-            }
-        }
-        if (white_cant_move_anywhere && is_under_attack(Piece::White, &pieces)) {
-            auto measurements = MeasureText("White is checkmated", 24);
-            DrawRectangle((screenWidth - measurements) / 2.0 - (0.5f * 24.0), (screenHeight / 2.0) - (0.3f * 48), measurements + 24.0, 48, BLACK);
-            DrawText("White is checkmated", (screenWidth - measurements) / 2.0, screenHeight / 2.0, 24, WHITE);
-        }
-        if (black_cant_move_anywhere && is_under_attack(Piece::Black, &pieces)) {
-            auto measurements = MeasureText("Black is checkmated", 24);
+        // Small endings are looked up, the side to move can't be checkmated in a drawn or won one
+        int wdl = probe_bitbase(&pieces, side_to_move(player.number_of_moves));
+        draw_bitbase_result(wdl);
+
+        // Only the side to move can be checkmated, so only its pieces need looking at
+        int color = side_to_move(player.number_of_moves);
+        bool cant_move_anywhere = wdl != Wdl::Draw && wdl != Wdl::Win && !has_legal_moves(&pieces, color);
+        if (cant_move_anywhere && is_under_attack(color, &pieces)) {
+            const char *text = color == Piece::White ? "White is checkmated" : "Black is checkmated";
+            auto measurements = MeasureText(text, 24);
             DrawRectangle((screenWidth - measurements) / 2.0 - (0.5f * 24.0), (screenHeight / 2.0) - (0.3f * 48), measurements + 24.0, 48, BLACK);
-            DrawText("Black is checkmated", (screenWidth - measurements) / 2.0, screenHeight / 2.0, 24, WHITE);
+            DrawText(text, (screenWidth - measurements) / 2.0, screenHeight / 2.0, 24, WHITE);
         }
+        draw_perf_overlay(&perf_overlay);
 
+        // EndDrawing also waits for the next frame, so it isn't part of draw
+        TRACE_RECORD("draw", draw_start);
         EndDrawing();
+        update_perf_overlay(&perf_overlay);
 
         //----------------------------------------------------------------------------------
     }
@@ -886,6 +426,7 @@ int main(void) {
     // De-Initialization
     //--------------------------------------------------------------------------------------
 
+    stop_mate_overlay(&mate_overlay);
     unload_textures(&piece_textures);
     CloseWindow();  // Close window and OpenGL context
     //--------------------------------------------------------------------------------------
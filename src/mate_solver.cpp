@@ -0,0 +1,183 @@
+#include "mate_solver.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "bitbase.h"
+#include "trace.h"
+
+namespace {
+    const uint32_t INFINITE = UINT32_MAX / 2;
+    const uint32_t NO_CHILDREN = UINT32_MAX;
+
+    // A node is an OR node when the attacker is to move (one proven child proves it)
+    // and an AND node when the defender is (every child has to be proven).
+    // Boards aren't stored, they're replayed from the root on the way down.
+    typedef struct Node {
+        Move move;
+        uint8_t depth;
+        uint8_t expanded;
+        uint32_t parent;
+        uint32_t first_child;
+        uint32_t child_count;
+        uint32_t proof;
+        uint32_t disproof;
+    } Node;
+
+    uint32_t saturated_add(uint32_t a, uint32_t b) { return std::min(INFINITE, a + b); }
+
+    bool is_or_node(Node *node) { return node->depth % 2 == 0; }
+
+    void set_proof_numbers(std::vector<Node> *tree, uint32_t index) {
+        Node &node = (*tree)[index];
+        uint32_t proof = is_or_node(&node) ? INFINITE : 0;
+        uint32_t disproof = is_or_node(&node) ? 0 : INFINITE;
+        for (uint32_t i = node.first_child; i < node.first_child + node.child_count; i++) {
+            Node &child = (*tree)[i];
+            if (is_or_node(&node)) {
+                proof = std::min(proof, child.proof);
+                disproof = saturated_add(disproof, child.disproof);
+            } else {
+                proof = saturated_add(proof, child.proof);
+                disproof = std::min(disproof, child.disproof);
+            }
+        }
+        node.proof = proof;
+        node.disproof = disproof;
+    }
+
+    // Creates the children of index, pieces is the position at index
+    void expand(std::vector<Node> *tree, uint32_t index, std::array<std::array<int, 8>, 8> *pieces, int color, int attacker, int max_depth) {
+        auto moves = get_legal_moves(pieces, color);
+        uint32_t first_child = tree->size();
+        uint8_t depth = (*tree)[index].depth + 1;
+
+        for (Move move : moves) {
+            auto cloned_pieces = (*pieces);
+            move_piece(&cloned_pieces, move_from(move), move_to(move));
+            int next = opposite_color(color);
+
+            Node child = {move, depth, 0, index, NO_CHILDREN, 0, 1, 1};
+            auto replies = get_legal_moves(&cloned_pieces, next);
+            if (replies.empty()) {
+                // Only a mate delivered by the attacker counts, stalemate or the attacker getting mated doesn't
+                bool mated = is_under_attack(next, &cloned_pieces);
+                if (mated && next != attacker) {
+                    child.proof = 0;
+                    child.disproof = INFINITE;
+                } else {
+                    child.proof = INFINITE;
+                    child.disproof = 0;
+                }
+            } else if (depth >= max_depth) {
+                // out of moves without mating
+                child.proof = INFINITE;
+                child.disproof = 0;
+            } else if (probe_bitbase(&cloned_pieces, next) == Wdl::Draw) {
+                // no mate at all, whatever the depth
+                child.proof = INFINITE;
+                child.disproof = 0;
+            } else if (next != attacker) {
+                // a defender with few replies is quicker to prove
+                child.proof = replies.size();
+            }
+            tree->push_back(child);
+        }
+
+        Node &node = (*tree)[index];
+        node.expanded = 1;
+        node.first_child = first_child;
+        node.child_count = moves.size();
+    }
+
+    // Number of plies to mate in a proven subtree, the attacker picks the fastest and the defender the slowest
+    int mate_distance(std::vector<Node> *tree, uint32_t index, std::vector<Move> *line) {
+        Node &node = (*tree)[index];
+        if (!node.expanded) {
+            line->clear();
+            return 0;
+        }
+
+        int best = -1;
+        std::vector<Move> best_line;
+        for (uint32_t i = node.first_child; i < node.first_child + node.child_count; i++) {
+            if ((*tree)[i].proof != 0) {
+                continue;
+            }
+            std::vector<Move> child_line;
+            int distance = mate_distance(tree, i, &child_line) + 1;
+            if (best == -1 || (is_or_node(&node) && distance < best) || (!is_or_node(&node) && distance > best)) {
+                best = distance;
+                best_line = {(*tree)[i].move};
+                best_line.insert(best_line.end(), child_line.begin(), child_line.end());
+            }
+        }
+        *line = best_line;
+        return best;
+    }
+    // Proof-number search for a mate within max_depth plies. It stops at the first proof,
+    // which isn't necessarily the shortest mate
+    MateResult search_mate(std::array<std::array<int, 8>, 8> *pieces, int color_to_move, int max_depth, size_t max_nodes, std::atomic<bool> *cancel) {
+        MateResult result;
+        std::vector<Node> tree;
+        tree.reserve(std::min<size_t>(max_nodes, 1 << 20));
+        tree.push_back(Node{0, 0, 0, NO_CHILDREN, NO_CHILDREN, 0, 1, 1});
+
+        while (tree[0].proof != 0 && tree[0].disproof != 0 && tree.size() < max_nodes) {
+            if (cancel && cancel->load(std::memory_order_relaxed)) {
+                break;
+            }
+            // Walk down to the most proving node
+            auto current = (*pieces);
+            int color = color_to_move;
+            uint32_t index = 0;
+            while (tree[index].expanded) {
+                Node &node = tree[index];
+                uint32_t best = node.first_child;
+                for (uint32_t i = node.first_child; i < node.first_child + node.child_count; i++) {
+                    if (is_or_node(&node) ? tree[i].proof < tree[best].proof : tree[i].disproof < tree[best].disproof) {
+                        best = i;
+                    }
+                }
+                index = best;
+                move_piece(&current, move_from(tree[index].move), move_to(tree[index].move));
+                color = opposite_color(color);
+            }
+
+            expand(&tree, index, &current, color, color_to_move, max_depth);
+
+            // and back up to the root
+            while (index != NO_CHILDREN) {
+                set_proof_numbers(&tree, index);
+                index = tree[index].parent;
+            }
+        }
+
+        result.nodes = tree.size();
+        if (tree[0].proof == 0) {
+            result.status = MateStatus::Proven;
+            mate_distance(&tree, 0, &result.line);
+        } else if (tree[0].disproof == 0) {
+            result.status = MateStatus::Disproven;
+        }
+        return result;
+    }
+}  // namespace
+
+MateResult solve_mate(std::array<std::array<int, 8>, 8> *pieces, int color_to_move, int mate_in, size_t max_nodes, std::atomic<bool> *cancel) {
+    TRACE_SCOPE("solve_mate");
+    MateResult result;
+    result.status = MateStatus::Disproven;
+
+    // Mate in 1, then 2, ... so the first proof is the shortest mate. Shallower searches are
+    // tiny next to the last one, and nodes used by them count against max_nodes
+    for (int n = 1; n <= mate_in && n <= 128; n++) {
+        MateResult search = search_mate(pieces, color_to_move, 2 * n - 1, result.nodes < max_nodes ? max_nodes - result.nodes : 0, cancel);
+        search.nodes += result.nodes;
+        result = search;
+        if (result.status != MateStatus::Disproven) {
+            break;
+        }
+    }
+    return result;
+}
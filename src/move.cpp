@@ -0,0 +1,101 @@
+#include "move.h"
+
+// The board is stored from the players point of view (their pieces are on y = 0),
+// so when the player is black the ranks are flipped compared to a normal board.
+int square_index(Position position) {
+    int rank = position.y;
+    if (player.color == Piece::Black) {
+        rank = 7 - position.y;
+    }
+    return rank * 8 + position.x;
+}
+
+Position position_from_square_index(int square) {
+    int rank = square / 8;
+    if (player.color == Piece::Black) {
+        rank = 7 - rank;
+    }
+    return Position{square % 8, rank};
+}
+
+Move encode_move(Position from, Position to) {
+    //
+    return (Move)((square_index(from) << 6) | square_index(to));
+}
+
+Position move_from(Move move) { return position_from_square_index((move >> 6) & 0b111111); }
+Position move_to(Move move) { return position_from_square_index(move & 0b111111); }
+
+std::vector<Move> get_legal_moves(std::array<std::array<int, 8>, 8> *pieces, int color) {
+    std::vector<Move> result;
+    for (int x = 0; x < 8; x++) {
+        for (int y = 0; y < 8; y++) {
+            if ((*pieces)[x][y] && piece_color((*pieces)[x][y]) == color) {
+                for (auto &position : get_legal_positions(pieces, x, y)) {
+                    result.push_back(encode_move(Position{x, y}, position));
+                }
+            }
+        }
+    }
+    return result;
+}
+
+bool is_legal_move(std::array<std::array<int, 8>, 8> *pieces, int color, Move move) {
+    // promotions and polyglot castling (king takes own rook) never pass, the rules have neither
+    if (move >> 12) {
+        return false;
+    }
+    Position from = move_from(move);
+    Position to = move_to(move);
+    int piece = (*pieces)[from.x][from.y];
+    if (!piece || piece_color(piece) != color) {
+        return false;
+    }
+    for (auto &position : get_legal_positions(pieces, from.x, from.y)) {
+        if (position.x == to.x && position.y == to.y) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool has_legal_moves(std::array<std::array<int, 8>, 8> *pieces, int color) {
+    for (int x = 0; x < 8; x++) {
+        for (int y = 0; y < 8; y++) {
+            if ((*pieces)[x][y] && piece_color((*pieces)[x][y]) == color) {
+                if (!get_legal_positions(pieces, x, y).empty()) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+std::string move_to_string(Move move) {
+    int from = (move >> 6) & 0b111111;
+    int to = move & 0b111111;
+
+    std::string s;
+    s.push_back('a' + from % 8);
+    s.push_back('1' + from / 8);
+    s.push_back('a' + to % 8);
+    s.push_back('1' + to / 8);
+    return s;
+}
+
+bool move_from_string(std::string s, Move *move) {
+    if (s.size() < 4) {
+        return false;
+    }
+    if (s[0] < 'a' || s[0] > 'h' || s[2] < 'a' || s[2] > 'h') {
+        return false;
+    }
+    if (s[1] < '1' || s[1] > '8' || s[3] < '1' || s[3] > '8') {
+        return false;
+    }
+    int from = (s[1] - '1') * 8 + (s[0] - 'a');
+    int to = (s[3] - '1') * 8 + (s[2] - 'a');
+    *move = (Move)((from << 6) | to);
+    return true;
+}
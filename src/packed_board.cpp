@@ -0,0 +1,21 @@
+#include "packed_board.h"
+
+PackedBoard pack_board(std::array<std::array<int, 8>, 8> *pieces) {
+    PackedBoard packed = {};
+    for (int x = 0; x < 8; x++) {
+        for (int y = 0; y < 8; y++) {
+            int square = x * 8 + y;
+            packed.squares[square / 2] |= packed_nibble((*pieces)[x][y]) << ((square % 2) * 4);
+        }
+    }
+    return packed;
+}
+
+void unpack_board(PackedBoard *packed, std::array<std::array<int, 8>, 8> *pieces) {
+    for (int x = 0; x < 8; x++) {
+        for (int y = 0; y < 8; y++) {
+            int square = x * 8 + y;
+            (*pieces)[x][y] = piece_from_nibble((packed->squares[square / 2] >> ((square % 2) * 4)) & 0b1111);
+        }
+    }
+}
@@ -0,0 +1,314 @@
+#include "pgn.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+bool move_from_san(std::array<std::array<int, 8>, 8> *pieces, int color, std::string san, Move *move) {
+    // check, mate and annotation marks don't change the move
+    while (!san.empty() && (san.back() == '+' || san.back() == '#' || san.back() == '!' || san.back() == '?')) {
+        san.pop_back();
+    }
+    // TODO: castling and promotion once the rules support them
+    if (san.starts_with("O-O") || san.starts_with("0-0") || san.find('=') != std::string::npos) {
+        return false;
+    }
+    std::erase(san, 'x');
+    if (san.size() < 2) {
+        return false;
+    }
+
+    int type = Piece::Pawn;
+    size_t start = 0;
+    switch (san[0]) {
+        case 'N':
+            type = Piece::Knight;
+            start = 1;
+            break;
+        case 'B':
+            type = Piece::Bishop;
+            start = 1;
+            break;
+        case 'R':
+            type = Piece::Rook;
+            start = 1;
+            break;
+        case 'Q':
+            type = Piece::Queen;
+            start = 1;
+            break;
+        case 'K':
+            type = Piece::King;
+            start = 1;
+            break;
+    }
+
+    char to_file = san[san.size() - 2];
+    char to_rank = san[san.size() - 1];
+    if (to_file < 'a' || to_file > 'h' || to_rank < '1' || to_rank > '8') {
+        return false;
+    }
+    Position to = position_from_square_index((to_rank - '1') * 8 + (to_file - 'a'));
+
+    // Disambiguation, "Nbd7", "R1e2" or "Qh4e1"
+    int from_file = -1;
+    int from_rank = -1;
+    for (size_t i = start; i < san.size() - 2; i++) {
+        if (san[i] >= 'a' && san[i] <= 'h') {
+            from_file = san[i] - 'a';
+        } else if (san[i] >= '1' && san[i] <= '8') {
+            from_rank = san[i] - '1';
+        } else {
+            return false;
+        }
+    }
+
+    int candidates = 0;
+    for (int x = 0; x < 8; x++) {
+        for (int y = 0; y < 8; y++) {
+            int piece = (*pieces)[x][y];
+            if (piece_type(piece) != type || piece_color(piece) != color) {
+                continue;
+            }
+            int square = square_index(Position{x, y});
+            if ((from_file != -1 && square % 8 != from_file) || (from_rank != -1 && square / 8 != from_rank)) {
+                continue;
+            }
+            auto legal_positions = get_legal_positions(pieces, x, y);
+            if (std::find(legal_positions.begin(), legal_positions.end(), to) != legal_positions.end()) {
+                *move = encode_move(Position{x, y}, to);
+                candidates++;
+            }
+        }
+    }
+    return candidates == 1;
+}
+
+std::string move_to_san(std::array<std::array<int, 8>, 8> *pieces, Move move) {
+    Position from = move_from(move);
+    Position to = move_to(move);
+    int piece = (*pieces)[from.x][from.y];
+    bool capture = (*pieces)[to.x][to.y] != Piece::None;
+    std::string destination = move_to_string(move).substr(2);
+
+    std::string san;
+    if (piece_type(piece) == Piece::Pawn) {
+        if (capture) {
+            san.push_back(move_to_string(move)[0]);
+        }
+    } else {
+        san.push_back(" P NBRQK"[piece_type(piece)]);
+
+        // Another piece of the same kind that can get there needs the file, rank or both
+        bool same_file = false;
+        bool same_rank = false;
+        bool ambiguous = false;
+        for (Move other : get_legal_moves(pieces, piece_color(piece))) {
+            Position other_from = move_from(other);
+            if (move_to(other) == to && !(other_from == from) && (*pieces)[other_from.x][other_from.y] == piece) {
+                ambiguous = true;
+                same_file = same_file || other_from.x == from.x;
+                same_rank = same_rank || other_from.y == from.y;
+            }
+        }
+        if (ambiguous) {
+            std::string square = move_to_string(move).substr(0, 2);
+            if (!same_file) {
+                san.push_back(square[0]);
+            } else if (!same_rank) {
+                san.push_back(square[1]);
+            } else {
+                san += square;
+            }
+        }
+    }
+    if (capture) {
+        san.push_back('x');
+    }
+    san += destination;
+
+    auto cloned_pieces = (*pieces);
+    move_piece(&cloned_pieces, from, to);
+    int opponent = opposite_color(piece_color(piece));
+    if (is_under_attack(opponent, &cloned_pieces)) {
+        san.push_back(has_legal_moves(&cloned_pieces, opponent) ? '+' : '#');
+    }
+    return san;
+}
+
+std::string line_to_san(std::array<std::array<int, 8>, 8> *pieces, std::vector<Move> *moves) {
+    auto cloned_pieces = (*pieces);
+    std::string line;
+    for (Move move : (*moves)) {
+        if (!line.empty()) {
+            line.push_back(' ');
+        }
+        line += move_to_san(&cloned_pieces, move);
+        move_piece(&cloned_pieces, move_from(move), move_to(move));
+    }
+    return line;
+}
+
+namespace {
+    int parse_result(std::string s) {
+        if (s == "1-0") {
+            return Result::WhiteWins;
+        } else if (s == "0-1") {
+            return Result::BlackWins;
+        } else if (s == "1/2-1/2") {
+            return Result::Draw;
+        }
+        return Result::Unknown;
+    }
+
+    // "2023.05.17" -> 20230517, unknown parts ("????.??.??") make the whole date unknown
+    uint32_t parse_date(std::string s) {
+        uint32_t date = 0;
+        int digits = 0;
+        for (char c : s) {
+            if (c == '?') {
+                return 0;
+            }
+            if (std::isdigit((unsigned char)c)) {
+                date = date * 10 + (c - '0');
+                digits++;
+            }
+        }
+        return digits == 8 ? date : 0;
+    }
+
+    struct PgnParser {
+        std::vector<PgnGame> games;
+        PgnGame game;
+        std::array<std::array<int, 8>, 8> pieces = init_pieces(player.color);
+        int color = Piece::White;
+        bool has_content = false;
+        bool in_moves = false;
+
+        void finish_game() {
+            if (has_content) {
+                games.push_back(std::move(game));
+            }
+            game = PgnGame{};
+            pieces = init_pieces(player.color);
+            color = Piece::White;
+            has_content = false;
+            in_moves = false;
+        }
+
+        void tag(std::string name, std::string value) {
+            // tags after the moves belong to the next game
+            if (in_moves) {
+                finish_game();
+            }
+            has_content = true;
+            if (name == "Result") {
+                game.result = parse_result(value);
+            } else if (name == "WhiteElo") {
+                game.white_elo = std::atoi(value.c_str());
+            } else if (name == "BlackElo") {
+                game.black_elo = std::atoi(value.c_str());
+            } else if (name == "Date") {
+                game.date = parse_date(value);
+            } else if (name == "FEN") {
+                // only games from the starting position can be replayed
+                game.complete = false;
+            }
+        }
+
+        void token(std::string s) {
+            if (s == "1-0" || s == "0-1" || s == "1/2-1/2" || s == "*") {
+                if (game.result == Result::Unknown) {
+                    game.result = parse_result(s);
+                }
+                has_content = true;
+                finish_game();
+                return;
+            }
+
+            // move numbers, "12." "12..." or glued on like "12.e4"
+            size_t i = 0;
+            while (i < s.size() && (std::isdigit((unsigned char)s[i]) || s[i] == '.')) {
+                i++;
+            }
+            s = s.substr(i);
+            if (s.empty()) {
+                return;
+            }
+
+            has_content = true;
+            in_moves = true;
+            if (!game.complete) {
+                return;
+            }
+            Move move;
+            if (!move_from_san(&pieces, color, s, &move)) {
+                game.complete = false;
+                return;
+            }
+            move_piece(&pieces, move_from(move), move_to(move));
+            game.moves.push_back(move);
+            color = opposite_color(color);
+        }
+    };
+}  // namespace
+
+std::vector<PgnGame> read_pgn(std::string text) {
+    PgnParser parser;
+
+    size_t i = 0;
+    while (i < text.size()) {
+        char c = text[i];
+        if (c == '[') {
+            size_t end = text.find(']', i);
+            if (end == std::string::npos) {
+                break;
+            }
+            std::string line = text.substr(i + 1, end - i - 1);
+            size_t space = line.find(' ');
+            size_t open_quote = line.find('"');
+            size_t close_quote = line.rfind('"');
+            if (space != std::string::npos && open_quote != std::string::npos && close_quote > open_quote) {
+                parser.tag(line.substr(0, space), line.substr(open_quote + 1, close_quote - open_quote - 1));
+            }
+            i = end + 1;
+        } else if (c == '{') {
+            size_t end = text.find('}', i);
+            i = (end == std::string::npos) ? text.size() : end + 1;
+        } else if (c == ';') {
+            size_t end = text.find('\n', i);
+            i = (end == std::string::npos) ? text.size() : end + 1;
+        } else if (c == '(') {
+            // skip variations, they can be nested
+            int depth = 0;
+            for (; i < text.size(); i++) {
+                if (text[i] == '(') {
+                    depth++;
+                } else if (text[i] == ')') {
+                    depth--;
+                    if (depth == 0) {
+                        i++;
+                        break;
+                    }
+                }
+            }
+        } else if (c == '$') {
+            i++;
+            while (i < text.size() && std::isdigit((unsigned char)text[i])) {
+                i++;
+            }
+        } else if (std::isspace((unsigned char)c)) {
+            i++;
+        } else {
+            size_t end = i;
+            while (end < text.size() && !std::isspace((unsigned char)text[end]) && text[end] != '{' && text[end] != '(' && text[end] != ';') {
+                end++;
+            }
+            parser.token(text.substr(i, end - i));
+            i = end;
+        }
+    }
+    parser.finish_game();
+
+    return parser.games;
+}
@@ -0,0 +1,333 @@
+#include "position_batch.h"
+
+#include <algorithm>
+
+// Squares are x * 8 + y like in PackedBoard, so a step in x is a shift by 8 and a step in y a shift by 1.
+// Every function here is branch free and forced inline on purpose, the loops over boards only vectorize that way.
+#if defined(__GNUC__)
+#define BATCH_INLINE inline __attribute__((always_inline))
+#else
+#define BATCH_INLINE inline
+#endif
+
+// Baseline x86-64 has no 64 bit vector compare, so the kernels get an AVX2 clone as well,
+// picked at load time on machines that have it
+#if defined(__x86_64__) && defined(__ELF__) && defined(__has_attribute)
+#if __has_attribute(target_clones)
+#define BATCH_KERNEL __attribute__((target_clones("avx2", "default")))
+#endif
+#endif
+#ifndef BATCH_KERNEL
+#define BATCH_KERNEL
+#endif
+
+namespace BatchMasks {
+    inline const uint64_t Y0 = 0x0101010101010101ULL;
+    inline const uint64_t Y1 = Y0 << 1;
+    inline const uint64_t Y6 = Y0 << 6;
+}  // namespace BatchMasks
+
+template <int S>
+BATCH_INLINE uint64_t shift(uint64_t b) {
+    if constexpr (S > 0) {
+        return b << S;
+    } else {
+        return b >> -S;
+    }
+}
+
+// stepping in y runs off the top of one column into the bottom of the next, this drops those squares
+template <int DY>
+constexpr uint64_t wrap_mask() {
+    uint64_t rows = 0;
+    for (int y = 0; y < 8; y++) {
+        if ((DY > 0 && y < DY) || (DY < 0 && y >= 8 + DY)) {
+            rows |= BatchMasks::Y0 << y;
+        }
+    }
+    return ~rows;
+}
+
+template <int DX, int DY>
+BATCH_INLINE uint64_t step(uint64_t b) {
+    return shift<DX * 8 + DY>(b) & wrap_mask<DY>();
+}
+
+// Squares reached going DX, DY from every square in from, up to and including the first piece.
+// Kogge-Stone fill, three doubling steps instead of a loop over the ray
+template <int DX, int DY>
+BATCH_INLINE uint64_t slide(uint64_t from, uint64_t empty) {
+    const int S = DX * 8 + DY;
+    uint64_t open = empty & wrap_mask<DY>();
+    from |= open & shift<S>(from);
+    open &= shift<S>(open);
+    from |= open & shift<2 * S>(from);
+    open &= shift<2 * S>(open);
+    from |= open & shift<4 * S>(from);
+    return step<DX, DY>(from);
+}
+
+// Without the popcnt instruction, there's no vector version of it below AVX-512
+BATCH_INLINE uint64_t count_bits(uint64_t b) {
+    b = b - ((b >> 1) & 0x5555555555555555ULL);
+    b = (b & 0x3333333333333333ULL) + ((b >> 2) & 0x3333333333333333ULL);
+    b = (b + (b >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    b += b >> 8;
+    b += b >> 16;
+    b += b >> 32;
+    return b & 0x7f;
+}
+
+// all ones if b isn't empty
+BATCH_INLINE uint64_t any(uint64_t b) { return -(uint64_t)(b != 0); }
+
+BATCH_INLINE uint64_t knight_targets(uint64_t b) {
+    return step<1, 2>(b) | step<2, 1>(b) | step<2, -1>(b) | step<1, -2>(b) | step<-1, -2>(b) | step<-2, -1>(b) | step<-2, 1>(b) | step<-1, 2>(b);
+}
+
+BATCH_INLINE uint64_t king_targets(uint64_t b) {
+    return step<0, 1>(b) | step<1, 1>(b) | step<1, 0>(b) | step<1, -1>(b) | step<0, -1>(b) | step<-1, -1>(b) | step<-1, 0>(b) | step<-1, 1>(b);
+}
+
+// up is all ones for pawns going towards y = 7
+BATCH_INLINE uint64_t pawn_targets(uint64_t pawns, uint64_t up) {
+    return ((step<1, 1>(pawns) | step<-1, 1>(pawns)) & up) | ((step<1, -1>(pawns) | step<-1, -1>(pawns)) & ~up);
+}
+
+BATCH_INLINE uint64_t pawn_forward(uint64_t pawns, uint64_t up) {
+    return (step<0, 1>(pawns) & up) | (step<0, -1>(pawns) & ~up);
+}
+
+// One board's bitboards, from the side to move's point of view
+typedef struct LaneBoard {
+    uint64_t us;
+    uint64_t them;
+    uint64_t empty;
+    uint64_t pawns;
+    uint64_t knights;
+    uint64_t diagonal;  // bishops and queens
+    uint64_t straight;  // rooks and queens
+    uint64_t kings;
+    uint64_t up;  // all ones when our pawns go towards y = 7
+} LaneBoard;
+
+// planes[j] is bit j of every square's nibble, white << 3 | piece_type
+BATCH_INLINE LaneBoard lane_board(uint64_t b0, uint64_t b1, uint64_t b2, uint64_t b3, uint64_t black_to_move, uint64_t up) {
+    LaneBoard board;
+    uint64_t occupied = b0 | b1 | b2;
+    uint64_t white = occupied & b3;
+    board.us = (white & ~black_to_move) | ((occupied ^ white) & black_to_move);
+    board.them = occupied ^ board.us;
+    board.empty = ~occupied;
+    board.pawns = b0 & ~b1 & ~b2;
+    board.knights = b0 & b1 & ~b2;
+    board.diagonal = b2 & ~b0;
+    board.straight = b2 & (b0 ^ b1);
+    board.kings = b0 & b1 & b2;
+    board.up = up;
+    return board;
+}
+
+template <int DX, int DY>
+BATCH_INLINE void check_ray(LaneBoard *board, uint64_t king, uint64_t sliders, uint64_t *checking, uint64_t *blocks) {
+    uint64_t ray = slide<DX, DY>(king, board->empty);
+    uint64_t hit = ray & sliders & board->them;
+    *checking |= hit;
+    *blocks |= ray & any(hit);
+}
+
+// Pieces of theirs attacking our king. blocks gets the squares between the king and sliders that check it
+BATCH_INLINE uint64_t checkers(LaneBoard *board, uint64_t *blocks) {
+    uint64_t king = board->kings & board->us;
+    uint64_t checking = (knight_targets(king) & board->knights & board->them) | (pawn_targets(king, board->up) & board->pawns & board->them) | (king_targets(king) & board->kings & board->them);
+    check_ray<0, 1>(board, king, board->straight, &checking, blocks);
+    check_ray<0, -1>(board, king, board->straight, &checking, blocks);
+    check_ray<1, 0>(board, king, board->straight, &checking, blocks);
+    check_ray<-1, 0>(board, king, board->straight, &checking, blocks);
+    check_ray<1, 1>(board, king, board->diagonal, &checking, blocks);
+    check_ray<-1, -1>(board, king, board->diagonal, &checking, blocks);
+    check_ray<1, -1>(board, king, board->diagonal, &checking, blocks);
+    check_ray<-1, 1>(board, king, board->diagonal, &checking, blocks);
+    return checking;
+}
+
+// our piece that's the only thing between the king and one of their sliders going DX, DY
+template <int DX, int DY>
+BATCH_INLINE uint64_t pinned(LaneBoard *board, uint64_t king, uint64_t sliders) {
+    uint64_t first = slide<DX, DY>(king, board->empty) & board->us;
+    uint64_t pinner = slide<DX, DY>(first, board->empty) & sliders & board->them;
+    return first & any(pinner);
+}
+
+// Squares they attack with our king taken off the board, so it can't hide behind itself
+BATCH_INLINE uint64_t attacked(LaneBoard *board, uint64_t king) {
+    uint64_t empty = board->empty | king;
+    uint64_t straight = board->straight & board->them;
+    uint64_t diagonal = board->diagonal & board->them;
+    return pawn_targets(board->pawns & board->them, ~board->up) | knight_targets(board->knights & board->them) | king_targets(board->kings & board->them) |
+           slide<0, 1>(straight, empty) | slide<0, -1>(straight, empty) | slide<1, 0>(straight, empty) | slide<-1, 0>(straight, empty) |
+           slide<1, 1>(diagonal, empty) | slide<-1, -1>(diagonal, empty) | slide<1, -1>(diagonal, empty) | slide<-1, 1>(diagonal, empty);
+}
+
+// Same count as adding up get_legal_positions over every piece of the side to move.
+// Sliders going the same way never share a target (the nearer one blocks the other), so each direction is one fill.
+BATCH_INLINE uint64_t legal_moves(LaneBoard *board, uint64_t *in_check) {
+    uint64_t king = board->kings & board->us;
+    uint64_t blocks = 0;
+    uint64_t checking = checkers(board, &blocks);
+    *in_check = any(checking);
+
+    // not in check anywhere goes, in check only capturing or blocking, in double check only the king moves
+    uint64_t single = -(uint64_t)((checking & (checking - 1)) == 0);
+    uint64_t targets = ~board->us & ((~*in_check) | (single & (checking | blocks)));
+
+    // pinned pieces can only move along the line they're pinned on
+    uint64_t straight = board->straight & board->them;
+    uint64_t diagonal = board->diagonal & board->them;
+    uint64_t pinned_y = pinned<0, 1>(board, king, straight) | pinned<0, -1>(board, king, straight);
+    uint64_t pinned_x = pinned<1, 0>(board, king, straight) | pinned<-1, 0>(board, king, straight);
+    uint64_t pinned_a = pinned<1, 1>(board, king, diagonal) | pinned<-1, -1>(board, king, diagonal);
+    uint64_t pinned_b = pinned<1, -1>(board, king, diagonal) | pinned<-1, 1>(board, king, diagonal);
+    uint64_t free = ~(pinned_y | pinned_x | pinned_a | pinned_b);
+
+    uint64_t count = 0;
+    uint64_t empty = board->empty;
+
+    uint64_t rooks = board->straight & board->us;
+    count += count_bits(slide<0, 1>(rooks & (free | pinned_y), empty) & targets);
+    count += count_bits(slide<0, -1>(rooks & (free | pinned_y), empty) & targets);
+    count += count_bits(slide<1, 0>(rooks & (free | pinned_x), empty) & targets);
+    count += count_bits(slide<-1, 0>(rooks & (free | pinned_x), empty) & targets);
+    uint64_t bishops = board->diagonal & board->us;
+    count += count_bits(slide<1, 1>(bishops & (free | pinned_a), empty) & targets);
+    count += count_bits(slide<-1, -1>(bishops & (free | pinned_a), empty) & targets);
+    count += count_bits(slide<1, -1>(bishops & (free | pinned_b), empty) & targets);
+    count += count_bits(slide<-1, 1>(bishops & (free | pinned_b), empty) & targets);
+
+    uint64_t knights = board->knights & board->us & free;
+    count += count_bits(step<1, 2>(knights) & targets) + count_bits(step<2, 1>(knights) & targets);
+    count += count_bits(step<2, -1>(knights) & targets) + count_bits(step<1, -2>(knights) & targets);
+    count += count_bits(step<-1, -2>(knights) & targets) + count_bits(step<-2, -1>(knights) & targets);
+    count += count_bits(step<-2, 1>(knights) & targets) + count_bits(step<-1, 2>(knights) & targets);
+
+    uint64_t up = board->up;
+    uint64_t pawns = board->pawns & board->us;
+    uint64_t pushers = pawns & (free | pinned_y);
+    uint64_t one = pawn_forward(pushers, up) & empty;
+    uint64_t start = (BatchMasks::Y1 & up) | (BatchMasks::Y6 & ~up);
+    uint64_t two = pawn_forward(pawn_forward(pushers & start, up) & empty, up) & empty;
+    count += count_bits(one & targets) + count_bits(two & targets);
+    // going up a capture towards +x is on the a diagonal, going down it's on the b one
+    uint64_t right = (step<1, 1>(pawns & (free | pinned_a)) & up) | (step<1, -1>(pawns & (free | pinned_b)) & ~up);
+    uint64_t left = (step<-1, 1>(pawns & (free | pinned_b)) & up) | (step<-1, -1>(pawns & (free | pinned_a)) & ~up);
+    count += count_bits(right & board->them & targets) + count_bits(left & board->them & targets);
+
+    count += count_bits(king_targets(king) & ~board->us & ~attacked(board, king));
+    return count;
+}
+
+void PositionBatch::add(std::array<std::array<int, 8>, 8> *pieces, int color_to_move) {
+    PackedBoard packed = pack_board(pieces);
+    add(&packed, color_to_move);
+}
+
+void PositionBatch::add(PackedBoard *board, int color_to_move) {
+    for (int k = 0; k < 32; k++) {
+        columns[k].push_back(board->squares[k]);
+    }
+    colors.push_back(color_to_move == Piece::White ? 0 : 1);
+}
+
+void PositionBatch::clear() {
+    for (auto &column : columns) {
+        column.clear();
+    }
+    colors.clear();
+}
+
+PackedBoard PositionBatch::board(size_t index) {
+    PackedBoard packed;
+    for (int k = 0; k < 32; k++) {
+        packed.squares[k] = columns[k][index];
+    }
+    return packed;
+}
+
+// Boards BLOCK at a time, unpacked into one bitboard per nibble bit
+typedef struct BatchBlock {
+    alignas(64) uint64_t planes[4][PositionBatches::BLOCK];
+    alignas(64) uint64_t black_to_move[PositionBatches::BLOCK];
+    alignas(64) uint64_t up[PositionBatches::BLOCK];
+} BatchBlock;
+
+BATCH_KERNEL void in_check_kernel(BatchBlock *block, size_t count, uint8_t *out) {
+    for (size_t lane = 0; lane < count; lane++) {
+        LaneBoard board = lane_board(block->planes[0][lane], block->planes[1][lane], block->planes[2][lane], block->planes[3][lane], block->black_to_move[lane], block->up[lane]);
+        uint64_t blocks = 0;
+        out[lane] = checkers(&board, &blocks) != 0;
+    }
+}
+
+BATCH_KERNEL void legal_move_count_kernel(BatchBlock *block, size_t count, uint16_t *out) {
+    for (size_t lane = 0; lane < count; lane++) {
+        LaneBoard board = lane_board(block->planes[0][lane], block->planes[1][lane], block->planes[2][lane], block->planes[3][lane], block->black_to_move[lane], block->up[lane]);
+        uint64_t checked;
+        out[lane] = legal_moves(&board, &checked);
+    }
+}
+
+BATCH_KERNEL void is_mate_kernel(BatchBlock *block, size_t count, uint8_t *out) {
+    for (size_t lane = 0; lane < count; lane++) {
+        LaneBoard board = lane_board(block->planes[0][lane], block->planes[1][lane], block->planes[2][lane], block->planes[3][lane], block->black_to_move[lane], block->up[lane]);
+        uint64_t checked;
+        uint64_t moves = legal_moves(&board, &checked);
+        out[lane] = (checked & ~any(moves)) != 0;
+    }
+}
+
+template <typename F>
+void PositionBatch::for_each_block(F f) {
+    BatchBlock block;
+    uint64_t player_is_black = player.color == Piece::Black;
+    for (size_t start = 0; start < size(); start += PositionBatches::BLOCK) {
+        size_t count = std::min(PositionBatches::BLOCK, size() - start);
+
+        for (int j = 0; j < 4; j++) {
+            std::fill(block.planes[j], block.planes[j] + count, 0);
+        }
+        for (int k = 0; k < 32; k++) {
+            const uint8_t *column = columns[k].data() + start;
+            for (int j = 0; j < 4; j++) {
+                uint64_t *plane = block.planes[j];
+                for (size_t lane = 0; lane < count; lane++) {
+                    uint64_t low = (column[lane] >> j) & 1;
+                    uint64_t high = (column[lane] >> (4 + j)) & 1;
+                    plane[lane] |= (low << (2 * k)) | (high << (2 * k + 1));
+                }
+            }
+        }
+        const uint8_t *black = colors.data() + start;
+        for (size_t lane = 0; lane < count; lane++) {
+            block.black_to_move[lane] = -(uint64_t)black[lane];
+            // the player's pawns go towards y = 7
+            block.up[lane] = -(uint64_t)(black[lane] == player_is_black);
+        }
+
+        f(start, count, &block);
+    }
+}
+
+void PositionBatch::in_check(std::vector<uint8_t> *results) {
+    results->resize(size());
+    for_each_block([&](size_t start, size_t count, BatchBlock *block) { in_check_kernel(block, count, results->data() + start); });
+}
+
+void PositionBatch::legal_move_count(std::vector<uint16_t> *results) {
+    results->resize(size());
+    for_each_block([&](size_t start, size_t count, BatchBlock *block) { legal_move_count_kernel(block, count, results->data() + start); });
+}
+
+void PositionBatch::is_mate(std::vector<uint8_t> *results) {
+    results->resize(size());
+    for_each_block([&](size_t start, size_t count, BatchBlock *block) { is_mate_kernel(block, count, results->data() + start); });
+}
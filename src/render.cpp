@@ -0,0 +1,142 @@
+#include "render.h"
+
+#include <string>
+
+// the only reason these are the same is because i used both 8,16 as flags for pieces and squares. the bit masks would have to be different if different numbers
+int square_color(int a) { return a & 0b11000; }
+
+bool square_is_selected(int a) { return (a & Square::Selected) == Square::Selected; }
+bool square_is_indicator(int a) { return (a & Square::Indicator) == Square::Indicator; }
+
+Rectangle rectangle_from_x_y(int x, int y) {
+    // TODO: bounds checking
+    return Rectangle{
+        (float)x * Constants::SQUARE_LENGTH,
+        (float)(7 - y) * Constants::SQUARE_LENGTH,
+        Constants::SQUARE_LENGTH,
+        Constants::SQUARE_LENGTH,
+    };
+};
+
+std::tuple<int, Texture2D> load_piece_texture(int piece) {
+    std::string filename = "assets/pieces/";
+
+    // Color
+    if (piece & Piece::Black) {
+        filename.append("b");
+    } else if (piece & Piece::White) {
+        filename.append("w");
+    }
+
+    if (piece_type(piece) == Piece::Queen) {
+        filename.append("Q");
+    } else if (piece_type(piece) == Piece::Bishop) {
+        filename.append("B");
+    } else if (piece_type(piece) == Piece::Pawn) {
+        filename.append("P");
+    } else if (piece_type(piece) == Piece::King) {
+        filename.append("K");
+    } else if (piece_type(piece) == Piece::Knight) {
+        filename.append("N");
+    } else if (piece_type(piece) == Piece::Rook) {
+        filename.append("R");
+    }
+
+    filename.append(".png");
+
+    return std::make_tuple(piece, LoadTexture(filename.c_str()));
+}
+
+std::vector<std::tuple<int, Texture2D>> load_textures(std::array<std::array<int, 8>, 8> *pieces) {
+    std::vector<std::tuple<int, Texture2D>> all_textures;
+    for (int row = 0; row < 8; row++) {
+        for (int column = 0; column < 8; column++) {
+            int piece = (*pieces)[row][column];
+            if (piece) {
+                all_textures.emplace_back(load_piece_texture(piece));
+            }
+        }
+    }
+    return all_textures;
+}
+
+void unload_textures(std::vector<std::tuple<int, Texture2D>> *piece_textures) {
+    for (const auto &[key, value] : (*piece_textures)) {
+        UnloadTexture(value);
+    }
+}
+
+std::array<std::array<int, 8>, 8> init_squares() {
+    std::array<std::array<int, 8>, 8> squares;
+    for (int row = 0; row < 8; row++) {
+        for (int column = 0; column < 8; column++) {
+            if ((row + column) % 2 == 0) {
+                squares[row][column] = Square::Light;
+            } else {
+                squares[row][column] = Square::Dark;
+            }
+        }
+    }
+    return squares;
+}
+
+void draw_piece_texture(Texture2D piece_texture, Rectangle dest_rect) {}
+void draw_piece_texture(Texture2D piece_texture, int x, int y) {
+    Rectangle dest_rect = rectangle_from_x_y(x, y);
+    DrawTexturePro(piece_texture, Rectangle{0, 0, (float)piece_texture.width, (float)piece_texture.height}, dest_rect, Vector2{0, 0}, 0, RAYWHITE);
+}
+
+void draw_pieces(std::array<std::array<int, 8>, 8> *pieces, std::vector<std::tuple<int, Texture2D>> *piece_textures) {
+    for (int row = 0; row < 8; row++) {
+        for (int column = 0; column < 8; column++) {
+            Rectangle dest_rect = rectangle_from_x_y(row, column);
+
+            Texture2D piece_texture;
+            bool found = false;
+            for (const auto &[key, value] : (*piece_textures)) {
+                if (key == (*pieces)[row][column]) {
+                    found = true;
+                    piece_texture = value;
+                }
+            }
+
+            if (found) {
+                draw_piece_texture(piece_texture, row, column);
+            }
+        }
+    }
+}
+
+void draw_squares(std::array<std::array<int, 8>, 8> *squares) {
+    for (int row = 0; row < 8; row++) {
+        for (int column = 0; column < 8; column++) {
+            auto rect = rectangle_from_x_y(row, column);
+            int current_square = (*squares)[row][column];
+            if (square_color(current_square) == Square::Dark) {
+                DrawRectangle(rect.x, rect.y, rect.width, rect.height, Constants::SQUARE_DARK);
+            } else if (square_color(current_square) == Square::Light) {
+                DrawRectangle(rect.x, rect.y, rect.width, rect.height, Constants::SQUARE_LIGHT);
+            }
+            // if (has_flag((*squares)[row][column], Square::Selected)) {
+            if (square_is_selected(current_square)) {
+                DrawRectangle(rect.x, rect.y, rect.width, rect.height, Constants::SQUARE_SELECTED);
+            }
+            if (square_is_indicator(current_square)) {
+                int centerX = rect.x + 0.5 * rect.width;
+                int centerY = rect.y + 0.5 * rect.height;
+                int radius = 0.125 * rect.width;
+                DrawCircle(centerX, centerY, radius, Constants::SQUARE_SELECTED);
+            }
+        }
+    }
+}
+
+void draw_move_arrow(Move move, Color color) {
+    Position from = move_from(move);
+    Position to = move_to(move);
+    Rectangle from_rect = rectangle_from_x_y(from.x, from.y);
+    Rectangle to_rect = rectangle_from_x_y(to.x, to.y);
+    Vector2 start = {from_rect.x + 0.5f * from_rect.width, from_rect.y + 0.5f * from_rect.height};
+    Vector2 end = {to_rect.x + 0.5f * to_rect.width, to_rect.y + 0.5f * to_rect.height};
+    DrawLineEx(start, end, 0.125 * from_rect.width, color);
+}
@@ -0,0 +1,138 @@
+#include "search.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "trace.h"
+
+namespace {
+    typedef struct SearchContext {
+        size_t nodes = 0;
+        size_t max_nodes = 0;
+        bool stopped = false;
+    } SearchContext;
+
+    bool is_capture(std::array<std::array<int, 8>, 8> *pieces, Move move) {
+        Position to = move_to(move);
+        return (*pieces)[to.x][to.y] != Piece::None;
+    }
+
+    // Captures of the most valuable pieces first, then everything else
+    void order_moves(std::array<std::array<int, 8>, 8> *pieces, std::vector<Move> *moves, Move first) {
+        auto value = [&](Move move) {
+            if (move == first) {
+                return Score::INFINITE;
+            }
+            Position to = move_to(move);
+            return Score::PIECE_VALUES[piece_type((*pieces)[to.x][to.y])];
+        };
+        std::stable_sort(moves->begin(), moves->end(), [&](Move a, Move b) { return value(a) > value(b); });
+    }
+
+    int quiescence(SearchContext *context, std::array<std::array<int, 8>, 8> *pieces, int color, int alpha, int beta) {
+        context->nodes++;
+        int stand_pat = evaluate(pieces, color);
+        if (stand_pat >= beta) {
+            return stand_pat;
+        }
+        alpha = std::max(alpha, stand_pat);
+
+        auto moves = get_legal_moves(pieces, color);
+        std::erase_if(moves, [&](Move move) { return !is_capture(pieces, move); });
+        order_moves(pieces, &moves, 0);
+        for (Move move : moves) {
+            auto cloned_pieces = (*pieces);
+            move_piece(&cloned_pieces, move_from(move), move_to(move));
+            int score = -quiescence(context, &cloned_pieces, opposite_color(color), -beta, -alpha);
+            if (score >= beta) {
+                return score;
+            }
+            alpha = std::max(alpha, score);
+        }
+        return alpha;
+    }
+
+    int negamax(SearchContext *context, std::array<std::array<int, 8>, 8> *pieces, int color, int depth, int ply, int alpha, int beta, Move *best_move, Move first) {
+        if (context->nodes >= context->max_nodes) {
+            context->stopped = true;
+            return 0;
+        }
+        context->nodes++;
+
+        auto moves = get_legal_moves(pieces, color);
+        if (moves.empty()) {
+            // mated, or stalemate
+            return is_under_attack(color, pieces) ? -Score::MATE + ply : 0;
+        }
+        if (depth == 0) {
+            return quiescence(context, pieces, color, alpha, beta);
+        }
+
+        order_moves(pieces, &moves, first);
+        int best = -Score::INFINITE;
+        for (Move move : moves) {
+            auto cloned_pieces = (*pieces);
+            move_piece(&cloned_pieces, move_from(move), move_to(move));
+            int score = -negamax(context, &cloned_pieces, opposite_color(color), depth - 1, ply + 1, -beta, -alpha, nullptr, 0);
+            if (context->stopped) {
+                return 0;
+            }
+            if (score > best) {
+                best = score;
+                if (best_move) {
+                    *best_move = move;
+                }
+            }
+            alpha = std::max(alpha, score);
+            if (alpha >= beta) {
+                break;
+            }
+        }
+        return best;
+    }
+}  // namespace
+
+int evaluate(std::array<std::array<int, 8>, 8> *pieces, int color) {
+    int score = 0;
+    for (int x = 0; x < 8; x++) {
+        for (int y = 0; y < 8; y++) {
+            int piece = (*pieces)[x][y];
+            if (piece) {
+                int value = Score::PIECE_VALUES[piece_type(piece)];
+                score += (piece_color(piece) == color) ? value : -value;
+            }
+        }
+    }
+    return score;
+}
+
+SearchResult search(std::array<std::array<int, 8>, 8> *pieces, int color, size_t max_nodes) {
+    TRACE_SCOPE("search");
+    SearchContext context;
+    context.max_nodes = max_nodes;
+
+    SearchResult result;
+    for (int depth = 1; depth < 64; depth++) {
+        Move best_move = 0;
+        // the previous depth's best move is searched first
+        int score = negamax(&context, pieces, color, depth, 0, -Score::INFINITE, Score::INFINITE, &best_move, result.best_move);
+        if (context.stopped) {
+            break;
+        }
+        result.best_move = best_move;
+        result.score = score;
+        result.depth = depth;
+        if (std::abs(score) >= Score::MATE - 64) {
+            break;
+        }
+    }
+    // not even depth 1 finished, at least return a legal move
+    if (!result.best_move) {
+        auto moves = get_legal_moves(pieces, color);
+        if (!moves.empty()) {
+            result.best_move = moves[0];
+        }
+    }
+    result.nodes = context.nodes;
+    return result;
+}
@@ -0,0 +1,127 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+namespace {
+    typedef struct ThreadTrace {
+        uint32_t thread_id;
+        std::atomic<uint64_t> head{0};
+        std::array<TraceEvent, Trace::RING_SIZE> events;
+        std::array<std::atomic<uint64_t>, TraceCounter::Count> counters{};
+    } ThreadTrace;
+
+    // Thread buffers live until the program exits so a dump still sees threads that finished
+    std::mutex threads_mutex;
+    std::vector<std::unique_ptr<ThreadTrace>> threads;
+    thread_local ThreadTrace *current = nullptr;
+
+    ThreadTrace *this_thread_trace() {
+        if (!current) {
+            std::lock_guard<std::mutex> lock(threads_mutex);
+            auto trace = std::make_unique<ThreadTrace>();
+            trace->thread_id = threads.size();
+            current = trace.get();
+            threads.push_back(std::move(trace));
+        }
+        return current;
+    }
+
+    void push_event(TraceEvent event) {
+        ThreadTrace *trace = this_thread_trace();
+        uint64_t head = trace->head.load(std::memory_order_relaxed);
+        trace->events[head % Trace::RING_SIZE] = event;
+        trace->head.store(head + 1, std::memory_order_release);
+    }
+
+    const auto process_start = std::chrono::steady_clock::now();
+}  // namespace
+
+uint64_t trace_now() {
+    //
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - process_start).count();
+}
+
+void trace_record(const char *name, uint64_t start_ns, uint64_t end_ns) {
+    //
+    push_event(TraceEvent{name, start_ns, end_ns - start_ns, false});
+}
+
+void trace_record_counter(const char *name, uint64_t value) {
+    //
+    push_event(TraceEvent{name, trace_now(), value, true});
+}
+
+void trace_count(int counter, uint64_t amount) {
+    //
+    this_thread_trace()->counters[counter].fetch_add(amount, std::memory_order_relaxed);
+}
+
+uint64_t trace_counter(int counter) {
+    std::lock_guard<std::mutex> lock(threads_mutex);
+    uint64_t total = 0;
+    for (auto &trace : threads) {
+        total += trace->counters[counter].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+std::vector<uint64_t> trace_recent(const char *name, size_t n) {
+    ThreadTrace *trace = this_thread_trace();
+    uint64_t head = trace->head.load(std::memory_order_acquire);
+    uint64_t oldest = (head > Trace::RING_SIZE) ? head - Trace::RING_SIZE : 0;
+
+    // walk backwards from the newest event
+    std::vector<uint64_t> result;
+    for (uint64_t i = head; i > oldest && result.size() < n; i--) {
+        TraceEvent &event = trace->events[(i - 1) % Trace::RING_SIZE];
+        if (!event.is_counter && (event.name == name || std::strcmp(event.name, name) == 0)) {
+            result.push_back(event.duration_ns);
+        }
+    }
+    std::reverse(result.begin(), result.end());
+    return result;
+}
+
+uint64_t trace_percentile(std::vector<uint64_t> values, double percentile) {
+    if (values.empty()) {
+        return 0;
+    }
+    size_t index = std::min(values.size() - 1, (size_t)(percentile / 100.0 * values.size()));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+bool trace_write_chrome_json(std::string path) {
+    FILE *file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        return false;
+    }
+
+    // Other threads may still be recording, their oldest events can be overwritten mid dump
+    std::lock_guard<std::mutex> lock(threads_mutex);
+    std::fprintf(file, "{\"traceEvents\":[\n");
+    bool first = true;
+    for (auto &trace : threads) {
+        uint64_t head = trace->head.load(std::memory_order_acquire);
+        uint64_t oldest = (head > Trace::RING_SIZE) ? head - Trace::RING_SIZE : 0;
+        for (uint64_t i = oldest; i < head; i++) {
+            TraceEvent &event = trace->events[i % Trace::RING_SIZE];
+            // timestamps are in microseconds
+            if (event.is_counter) {
+                std::fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"value\":%llu}}", first ? "" : ",\n", event.name, event.start_ns / 1000.0, trace->thread_id, (unsigned long long)event.duration_ns);
+            } else {
+                std::fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}", first ? "" : ",\n", event.name, event.start_ns / 1000.0, event.duration_ns / 1000.0, trace->thread_id);
+            }
+            first = false;
+        }
+    }
+    std::fprintf(file, "\n]}\n");
+    return std::fclose(file) == 0;
+}
@@ -0,0 +1,84 @@
+#include "training_data.h"
+
+#include <filesystem>
+
+#include "move.h"
+
+PackedPosition pack_position(std::array<std::array<int, 8>, 8> *pieces, int color_to_move) {
+    PackedPosition packed = {};
+    int count = 0;
+    for (int square = 0; square < 64; square++) {
+        Position position = position_from_square_index(square);
+        int piece = (*pieces)[position.x][position.y];
+        if (!piece || count == 32) {
+            continue;
+        }
+        int nibble = ((piece_color(piece) == Piece::White) ? 0b1000 : 0) | piece_type(piece);
+        packed.occupancy |= (uint64_t)1 << square;
+        packed.pieces[count / 2] |= nibble << ((count % 2) * 4);
+        count++;
+    }
+    packed.color = (color_to_move == Piece::White) ? 0 : 1;
+    return packed;
+}
+
+void unpack_position(PackedPosition *packed, std::array<std::array<int, 8>, 8> *pieces, int *color_to_move) {
+    (*pieces) = {};
+    int count = 0;
+    for (int square = 0; square < 64; square++) {
+        if (!(packed->occupancy & ((uint64_t)1 << square))) {
+            continue;
+        }
+        int nibble = (packed->pieces[count / 2] >> ((count % 2) * 4)) & 0b1111;
+        Position position = position_from_square_index(square);
+        (*pieces)[position.x][position.y] = ((nibble & 0b1000) ? Piece::White : Piece::Black) | (nibble & 0b0111);
+        count++;
+    }
+    *color_to_move = packed->color ? Piece::Black : Piece::White;
+}
+
+ChunkWriter::ChunkWriter(std::string dir, std::string prefix, size_t positions_per_chunk) : dir(dir), prefix(prefix), positions_per_chunk(positions_per_chunk) {
+    std::filesystem::create_directories(dir);
+    open_chunk();
+}
+
+ChunkWriter::~ChunkWriter() {
+    if (file) {
+        std::fclose(file);
+    }
+}
+
+bool ChunkWriter::open_chunk() {
+    if (file) {
+        std::fclose(file);
+        file = nullptr;
+    }
+    // skip over chunks that are already full
+    while (true) {
+        std::filesystem::path path = std::filesystem::path(dir) / (prefix + "-" + std::to_string(chunk) + ".bin");
+        std::error_code error;
+        auto size = std::filesystem::file_size(path, error);
+        if (error) {
+            size = 0;
+        }
+        // a chunk cut off mid position (crash while writing) is left alone
+        if (size % sizeof(PackedPosition) == 0 && size / sizeof(PackedPosition) < positions_per_chunk) {
+            file = std::fopen(path.c_str(), "ab");
+            written = size / sizeof(PackedPosition);
+            return file != nullptr;
+        }
+        chunk++;
+    }
+}
+
+bool ChunkWriter::write(PackedPosition *position) {
+    if (written >= positions_per_chunk) {
+        chunk++;
+        open_chunk();
+    }
+    if (!file || std::fwrite(position, sizeof(PackedPosition), 1, file) != 1) {
+        return false;
+    }
+    written++;
+    return true;
+}
@@ -0,0 +1,121 @@
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "move.h"
+#include "position_batch.h"
+
+void usage() {
+    std::cerr << "usage: chess_batch_check [-games N] [-boards N] [-seed N]\n"
+                 "       compares the PositionBatch kernels with the scalar rules, exits 1 on any difference\n";
+}
+
+typedef struct CheckPosition {
+    std::array<std::array<int, 8>, 8> pieces;
+    int color;
+} CheckPosition;
+
+// Every position of random games, the kind of boards the batch is used on
+void add_playouts(int games, std::mt19937_64 *random, std::vector<CheckPosition> *positions) {
+    for (int game = 0; game < games; game++) {
+        auto pieces = init_pieces(player.color);
+        int color = Piece::White;
+        for (int ply = 0; ply < 120; ply++) {
+            positions->push_back({pieces, color});
+            auto moves = get_legal_moves(&pieces, color);
+            if (moves.empty()) {
+                break;
+            }
+            Move move = moves[(*random)() % moves.size()];
+            move_piece(&pieces, move_from(move), move_to(move));
+            color = opposite_color(color);
+        }
+    }
+}
+
+// Kings and a handful of random pieces anywhere, these find the odd checks and pins playouts rarely reach
+void add_random_boards(int boards, std::mt19937_64 *random, std::vector<CheckPosition> *positions) {
+    const int types[] = {Piece::Pawn, Piece::Pawn, Piece::Pawn, Piece::Knight, Piece::Bishop, Piece::Rook, Piece::Queen};
+    for (int i = 0; i < boards; i++) {
+        CheckPosition position{};
+        auto place = [&](int piece) {
+            while (true) {
+                int square = (*random)() % 64;
+                if (!position.pieces[square / 8][square % 8]) {
+                    position.pieces[square / 8][square % 8] = piece;
+                    return;
+                }
+            }
+        };
+        place(Piece::White | Piece::King);
+        place(Piece::Black | Piece::King);
+        int count = (*random)() % 12;
+        for (int k = 0; k < count; k++) {
+            int color = ((*random)() & 1) ? Piece::White : Piece::Black;
+            place(color | types[(*random)() % 7]);
+        }
+        position.color = ((*random)() & 1) ? Piece::White : Piece::Black;
+        positions->push_back(position);
+    }
+}
+
+int main(int argc, char **argv) {
+    int games = 300;
+    int boards = 20000;
+    uint64_t seed = 7;
+    for (int i = 1; i < argc; i += 2) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        } else if (arg == "-games") {
+            games = std::atoi(argv[i + 1]);
+        } else if (arg == "-boards") {
+            boards = std::atoi(argv[i + 1]);
+        } else if (arg == "-seed") {
+            seed = std::strtoull(argv[i + 1], nullptr, 10);
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    std::mt19937_64 random(seed);
+    std::vector<CheckPosition> positions;
+    add_playouts(games, &random, &positions);
+    add_random_boards(boards, &random, &positions);
+
+    PositionBatch batch;
+    for (auto &position : positions) {
+        batch.add(&position.pieces, position.color);
+    }
+    std::vector<uint8_t> checks;
+    std::vector<uint16_t> counts;
+    std::vector<uint8_t> mates;
+    batch.in_check(&checks);
+    batch.legal_move_count(&counts);
+    batch.is_mate(&mates);
+
+    int mismatches = 0;
+    for (size_t i = 0; i < positions.size(); i++) {
+        auto &[pieces, color] = positions[i];
+        bool in_check = is_under_attack(color, &pieces);
+        size_t count = get_legal_moves(&pieces, color).size();
+        bool is_mate = in_check && count == 0;
+
+        PackedBoard packed = batch.board(i);
+        std::array<std::array<int, 8>, 8> unpacked;
+        unpack_board(&packed, &unpacked);
+
+        if (in_check != (bool)checks[i] || count != counts[i] || is_mate != (bool)mates[i] || unpacked != pieces) {
+            if (mismatches++ < 10) {
+                std::cout << std::format("position {}: check {}/{} moves {}/{} mate {}/{} (scalar/batch)\n", i, (int)in_check, (int)checks[i], count, counts[i], (int)is_mate, (int)mates[i]);
+            }
+        }
+    }
+    std::cout << std::format("{} positions, {} mismatches\n", positions.size(), mismatches);
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <string>
+#include <vector>
+
+#include "bitbase.h"
+
+void usage() {
+    std::cerr << "usage: chess_bitbase generate <material> <out.bin> [threads]\n"
+                 "       chess_bitbase embed <out.cpp> <material>...\n";
+}
+
+// keeps generated tables alive, they're registered by pointer
+std::list<std::vector<unsigned char>> generated;
+std::vector<std::string> known;
+
+// Generates material and, first, every smaller material set a capture can lead to
+bool generate(std::string material, int threads) {
+    if (std::find(known.begin(), known.end(), material) != known.end()) {
+        return true;
+    }
+    // Everything but the kings can be captured
+    int kings = 0;
+    for (size_t i = 0; i < material.size(); i++) {
+        if (material[i] == 'K') {
+            kings++;
+            continue;
+        }
+        std::string smaller = material.substr(0, i) + material.substr(i + 1);
+        if (smaller != "KK" && !generate(smaller, threads)) {
+            return false;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto &table = generated.emplace_back();
+    if (kings != 2 || !generate_bitbase(material, &table, threads)) {
+        std::cerr << std::format("can't generate {}\n", material);
+        return false;
+    }
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+    register_bitbase(material, table.data(), table.size());
+    known.push_back(material);
+
+    size_t wins = 0;
+    size_t losses = 0;
+    for (unsigned char byte : table) {
+        for (int i = 0; i < 4; i++) {
+            int value = (byte >> (i * 2)) & 0b11;
+            wins += (value == Wdl::Win);
+            losses += (value == Wdl::Loss);
+        }
+    }
+    std::cerr << std::format("{}: {} wins, {} losses, {} bytes in {} ms\n", material, wins, losses, table.size(), ms);
+    return true;
+}
+
+int write_binary(std::string material, std::string path, int threads) {
+    if (!generate(material, threads)) {
+        return 1;
+    }
+    std::ofstream out(path, std::ios::binary);
+    auto &table = generated.back();
+    out.write((const char *)table.data(), table.size());
+    return out ? 0 : 1;
+}
+
+// Writes a source file with the tables as byte arrays and load_embedded_bitbases() to register them
+int write_embedded(std::string path, std::vector<std::string> materials) {
+    std::ofstream out(path);
+    out << "// Generated by chess_bitbase embed, don't edit\n\n#include \"bitbase.h\"\n\n";
+    for (auto &material : materials) {
+        if (!generate(material, 0)) {
+            return 1;
+        }
+        // generate() may have made smaller tables too, find this one
+        auto it = generated.begin();
+        std::advance(it, std::find(known.begin(), known.end(), material) - known.begin());
+
+        out << std::format("static const unsigned char bitbase_{}[{}] = {{", material, it->size());
+        for (size_t i = 0; i < it->size(); i++) {
+            out << ((i % 32 == 0) ? "\n    " : "") << (int)(*it)[i] << ",";
+        }
+        out << "\n};\n\n";
+    }
+    out << "void load_embedded_bitbases() {\n";
+    for (auto &material : materials) {
+        out << std::format("    register_bitbase(\"{}\", bitbase_{}, sizeof(bitbase_{}));\n", material, material, material);
+    }
+    out << "}\n";
+    return out ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 4) {
+        usage();
+        return 1;
+    }
+    std::string command = argv[1];
+
+    if (command == "generate") {
+        return write_binary(argv[2], argv[3], argc > 4 ? std::atoi(argv[4]) : 0);
+    } else if (command == "embed") {
+        return write_embedded(argv[2], std::vector<std::string>(argv + 3, argv + argc));
+    }
+    usage();
+    return 1;
+}
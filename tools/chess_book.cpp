@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "book.h"
+#include "game_store.h"
+#include "pgn.h"
+#include "zobrist.h"
+
+void usage() {
+    std::cerr << "usage: chess_book build <book.bin> <games.bin|games.pgn>... [--plies N]\n"
+                 "       chess_book probe <book.bin> [e2e4 e7e5 ...]\n";
+}
+
+// Polyglot style scoring, a move gets 2 points when its side won, 1 for a draw and nothing for a loss
+uint64_t move_score(int result, int color) {
+    if (result == Result::Draw || result == Result::Unknown) {
+        return 1;
+    }
+    if ((result == Result::WhiteWins) == (color == Piece::White)) {
+        return 2;
+    }
+    return 0;
+}
+
+void add_game(std::span<const Move> moves, int result, int max_plies, std::vector<BookEntry> *entries) {
+    auto pieces = init_pieces(player.color);
+    int color = Piece::White;
+    uint64_t key = hash_position(&pieces, color);
+
+    for (int ply = 0; ply < (int)moves.size() && ply < max_plies; ply++) {
+        Position from = move_from(moves[ply]);
+        Position to = move_to(moves[ply]);
+        entries->push_back({key, moves[ply], 0, (uint32_t)move_score(result, color)});
+
+        key = hash_after_move(key, &pieces, from, to);
+        move_piece(&pieces, from, to);
+        color = opposite_color(color);
+    }
+}
+
+bool add_games(std::string path, int max_plies, std::vector<BookEntry> *entries) {
+    if (path.ends_with(".pgn")) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            return false;
+        }
+        std::stringstream text;
+        text << in.rdbuf();
+        // incomplete games still have good moves up to where the rules gave up
+        for (auto &game : read_pgn(text.str())) {
+            add_game(game.moves, game.result, max_plies, entries);
+        }
+        return true;
+    }
+
+    GameReader games(path);
+    if (!games.is_open()) {
+        return false;
+    }
+    for (uint32_t game_id = 0; game_id < games.game_count(); game_id++) {
+        add_game(games.moves(game_id), games.header(game_id).result, max_plies, entries);
+    }
+    return true;
+}
+
+int build(std::string book_path, std::vector<std::string> game_paths, int max_plies) {
+    // the score is kept in learn until entries are merged
+    std::vector<BookEntry> raw;
+    for (auto &path : game_paths) {
+        if (!add_games(path, max_plies, &raw)) {
+            std::cerr << std::format("can't read {}\n", path);
+            return 1;
+        }
+    }
+
+    std::sort(raw.begin(), raw.end(), [](const BookEntry &lhs, const BookEntry &rhs) {
+        if (lhs.key != rhs.key) {
+            return lhs.key < rhs.key;
+        }
+        return lhs.move < rhs.move;
+    });
+
+    std::vector<std::pair<BookEntry, uint64_t>> merged;
+    uint64_t max_score = 0;
+    for (auto &e : raw) {
+        if (merged.empty() || merged.back().first.key != e.key || merged.back().first.move != e.move) {
+            merged.push_back({BookEntry{e.key, e.move, 0, 0}, 0});
+        }
+        merged.back().second += e.learn;
+        max_score = std::max(max_score, merged.back().second);
+    }
+
+    // Scale scores down so the biggest one fits in 16 bits, moves that never scored are dropped
+    std::vector<BookEntry> entries;
+    for (auto &[e, score] : merged) {
+        if (score == 0) {
+            continue;
+        }
+        uint64_t weight = score;
+        if (max_score > UINT16_MAX) {
+            weight = std::max<uint64_t>(1, score * UINT16_MAX / max_score);
+        }
+        entries.push_back(BookEntry{e.key, e.move, (uint16_t)weight, 0});
+    }
+
+    if (!write_book(&entries, book_path)) {
+        std::cerr << std::format("failed writing {}\n", book_path);
+        return 1;
+    }
+    std::cout << std::format("wrote {} entries from {} moves\n", entries.size(), raw.size());
+    return 0;
+}
+
+int probe(std::string book_path, int argc, char **argv) {
+    Book book(book_path);
+    if (!book.is_open()) {
+        std::cerr << std::format("can't open {}\n", book_path);
+        return 1;
+    }
+
+    auto pieces = init_pieces(player.color);
+    int color = Piece::White;
+    for (int i = 0; i < argc; i++) {
+        Move move;
+        if (!move_from_string(argv[i], &move)) {
+            std::cerr << std::format("bad move {}\n", argv[i]);
+            return 1;
+        }
+        if (!is_legal_move(&pieces, color, move)) {
+            std::cerr << std::format("illegal move {}\n", argv[i]);
+            return 1;
+        }
+        move_piece(&pieces, move_from(move), move_to(move));
+        color = opposite_color(color);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto entries = book.find(hash_position(&pieces, color));
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+    for (auto &e : entries) {
+        // castling and promotions from other programs' books can't be played here
+        std::cout << std::format("{} {}{}\n", move_to_string(e.move), e.weight, is_legal_move(&pieces, color, e.move) ? "" : " (not playable)");
+    }
+    std::cout << std::format("{} moves in {} us\n", entries.size(), us);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        usage();
+        return 1;
+    }
+    std::string command = argv[1];
+
+    if (command == "build" && argc >= 4) {
+        int max_plies = 24;
+        std::vector<std::string> game_paths;
+        for (int i = 3; i < argc; i++) {
+            if (std::string(argv[i]) == "--plies" && i + 1 < argc) {
+                max_plies = std::atoi(argv[++i]);
+            } else {
+                game_paths.push_back(argv[i]);
+            }
+        }
+        return build(argv[2], game_paths, max_plies);
+    } else if (command == "probe") {
+        return probe(argv[2], argc - 3, argv + 3);
+    }
+    usage();
+    return 1;
+}
@@ -0,0 +1,171 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bitbase.h"
+#include "book.h"
+#include "search.h"
+#include "training_data.h"
+#include "zobrist.h"
+
+void usage() {
+    std::cerr << "usage: chess_datagen <out_dir> [-games N] [-nodes N] [-threads N] [-random-plies N] [-book book.bin] [-chunk N]\n";
+}
+
+typedef struct Settings {
+    std::string out_dir;
+    long games = 1000;
+    size_t nodes = 5000;
+    int threads = 0;
+    int random_plies = 8;
+    int max_plies = 300;
+    std::string book_path;
+    size_t positions_per_chunk = 1 << 20;
+} Settings;
+
+std::atomic<long> games_started = 0;
+std::atomic<long> positions_written = 0;
+
+// Plays one game and writes its quiet positions, labelled with the result once it's known
+void play_game(Settings *settings, Book *book, std::mt19937_64 *random, ChunkWriter *writer) {
+    auto pieces = init_pieces(player.color);
+    int color = Piece::White;
+
+    // Randomized opening, book moves while there are any, then random legal moves
+    bool in_book = book->is_open();
+    for (int ply = 0; ply < settings->random_plies; ply++) {
+        Move move;
+        // other programs' books can have moves the rules don't allow, like castling
+        if (!in_book || !book->pick(hash_position(&pieces, color), (*random)(), &move) || !is_legal_move(&pieces, color, move)) {
+            in_book = false;
+            auto moves = get_legal_moves(&pieces, color);
+            if (moves.empty()) {
+                return;
+            }
+            move = moves[(*random)() % moves.size()];
+        }
+        move_piece(&pieces, move_from(move), move_to(move));
+        color = opposite_color(color);
+    }
+
+    std::vector<PackedPosition> positions;
+    std::vector<uint64_t> history;
+    int winner = 0;  // color that won, 0 for a draw
+    for (int ply = settings->random_plies; ply < settings->max_plies; ply++) {
+        // third repetition is a draw, and stops the game from writing the same positions over and over
+        uint64_t key = hash_position(&pieces, color);
+        history.push_back(key);
+        if (std::count(history.begin(), history.end(), key) >= 3) {
+            break;
+        }
+
+        // small endings are adjudicated by the bitbases
+        int wdl = probe_bitbase(&pieces, color);
+        if (wdl == Wdl::Win || wdl == Wdl::Loss) {
+            winner = (wdl == Wdl::Win) ? color : opposite_color(color);
+            break;
+        } else if (wdl == Wdl::Draw) {
+            break;
+        }
+
+        SearchResult result = search(&pieces, color, settings->nodes);
+        if (!has_legal_moves(&pieces, color)) {
+            if (is_under_attack(color, &pieces)) {
+                winner = opposite_color(color);
+            }
+            break;
+        }
+
+        // Only quiet positions make good labels, skip checks, captures and mate scores
+        Position to = move_to(result.best_move);
+        bool tactical = is_under_attack(color, &pieces) || pieces[to.x][to.y] != Piece::None || std::abs(result.score) >= Score::MATE - 256;
+        if (!tactical) {
+            PackedPosition packed = pack_position(&pieces, color);
+            packed.score = result.score;
+            packed.ply = ply;
+            positions.push_back(packed);
+        }
+
+        move_piece(&pieces, move_from(result.best_move), to);
+        color = opposite_color(color);
+    }
+
+    for (auto &packed : positions) {
+        int packed_color = packed.color ? Piece::Black : Piece::White;
+        packed.result = (winner == 0) ? 0 : (winner == packed_color ? 1 : -1);
+        writer->write(&packed);
+    }
+    positions_written += positions.size();
+}
+
+void worker(Settings *settings, int thread_index, uint64_t seed) {
+    // every thread has its own book mapping, rng and chunk files, nothing is shared but the counters
+    Book book(settings->book_path);
+    std::mt19937_64 random(seed + thread_index);
+    ChunkWriter writer(settings->out_dir, std::format("thread{}", thread_index), settings->positions_per_chunk);
+
+    while (games_started++ < settings->games) {
+        play_game(settings, &book, &random, &writer);
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        usage();
+        return 1;
+    }
+    Settings settings;
+    settings.out_dir = argv[1];
+    for (int i = 2; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "-games") {
+            settings.games = std::atol(argv[i + 1]);
+        } else if (arg == "-nodes") {
+            settings.nodes = std::atol(argv[i + 1]);
+        } else if (arg == "-threads") {
+            settings.threads = std::atoi(argv[i + 1]);
+        } else if (arg == "-random-plies") {
+            settings.random_plies = std::atoi(argv[i + 1]);
+        } else if (arg == "-book") {
+            settings.book_path = argv[i + 1];
+        } else if (arg == "-chunk") {
+            // a chunk has to hold at least one position or the writer never finishes one
+            long chunk = std::atol(argv[i + 1]);
+            if (chunk <= 0) {
+                usage();
+                return 1;
+            }
+            settings.positions_per_chunk = chunk;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (settings.threads <= 0) {
+        settings.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    load_embedded_bitbases();
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t seed = start.time_since_epoch().count();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < settings.threads; i++) {
+        threads.emplace_back(worker, &settings, i, seed);
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    long positions = positions_written;
+    std::cout << std::format("{} positions from {} games in {:.1f} s, {:.0f} positions/s per core\n", positions, settings.games, seconds, positions / seconds / settings.threads);
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <string>
+
+#include "bitbase.h"
+#include "fen.h"
+#include "mate_solver.h"
+#include "pgn.h"
+
+void usage() {
+    std::cerr << "usage: chess_mate [-n mate_in] [-nodes max_nodes] [fen]\n"
+                 "       without a fen, solves one fen per line from stdin\n";
+}
+
+// "#3 Qh5+ Kd8 Qe8#", "-" for no mate or "?" when it ran out of nodes
+std::string solve(std::string fen, int mate_in, size_t max_nodes) {
+    std::array<std::array<int, 8>, 8> pieces;
+    int color;
+    if (!board_from_fen(fen, &pieces, &color)) {
+        return "bad fen";
+    }
+
+    MateResult result = solve_mate(&pieces, color, mate_in, max_nodes);
+    if (result.status == MateStatus::Disproven) {
+        return "-";
+    } else if (result.status == MateStatus::Unknown) {
+        return "?";
+    }
+
+    return std::format("#{} {}", (result.line.size() + 1) / 2, line_to_san(&pieces, &result.line));
+}
+
+int main(int argc, char **argv) {
+    load_embedded_bitbases();
+
+    int mate_in = 3;
+    size_t max_nodes = 2000000;
+    std::string fen;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-n" && i + 1 < argc) {
+            mate_in = std::atoi(argv[++i]);
+        } else if (arg == "-nodes" && i + 1 < argc) {
+            max_nodes = std::atoll(argv[++i]);
+        } else if (arg.starts_with("-")) {
+            usage();
+            return 1;
+        } else {
+            fen = fen.empty() ? arg : fen + " " + arg;
+        }
+    }
+
+    if (!fen.empty()) {
+        std::cout << solve(fen, mate_in, max_nodes) << "\n";
+        return 0;
+    }
+
+    // Batch mode, for validating puzzle collections
+    auto start = std::chrono::steady_clock::now();
+    int solved = 0;
+    int total = 0;
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        std::string answer = solve(line, mate_in, max_nodes);
+        solved += answer.starts_with("#");
+        total++;
+        std::cout << line << " ; " << answer << "\n";
+    }
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << std::format("{}/{} mates in {} ms\n", solved, total, ms);
+    return 0;
+}
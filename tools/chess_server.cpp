@@ -0,0 +1,50 @@
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "game_server.h"
+
+void usage() {
+    std::cerr << "usage: chess_server <socket_path> [-threads N]\n";
+}
+
+GameServer *server = nullptr;
+
+void handle_signal(int) {
+    if (server) {
+        server->stop();
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        usage();
+        return 1;
+    }
+    std::string path = argv[1];
+    int threads = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() - 1 : 1;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-threads" && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    GameServer game_server = GameServer(threads);
+    if (!game_server.listen(path)) {
+        std::cerr << "can't listen on " << path << "\n";
+        return 1;
+    }
+    server = &game_server;
+    std::signal(SIGINT, handle_signal);
+    std::signal(SIGTERM, handle_signal);
+
+    std::cerr << "serving games on " << path << "\n";
+    game_server.run();
+    return 0;
+}
@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "game_store.h"
+#include "pgn.h"
+#include "zobrist.h"
+
+void usage() {
+    std::cerr << "usage: chess_store import <games.pgn> <games.bin>\n"
+                 "       chess_store index <games.bin> <games.idx> [threads]\n"
+                 "       chess_store find <games.bin> <games.idx> [e2e4 e7e5 ...]\n";
+}
+
+int import_pgn(std::string pgn_path, std::string store_path) {
+    std::ifstream in(pgn_path, std::ios::binary);
+    if (!in) {
+        std::cerr << std::format("can't open {}\n", pgn_path);
+        return 1;
+    }
+    std::stringstream text;
+    text << in.rdbuf();
+
+    GameWriter writer(store_path);
+    if (!writer.is_open()) {
+        std::cerr << std::format("can't open {}\n", store_path);
+        return 1;
+    }
+
+    int imported = 0;
+    int skipped = 0;
+    for (auto &game : read_pgn(text.str())) {
+        // Games the rules can't replay all the way would give a wrong position index
+        if (!game.complete) {
+            skipped++;
+            continue;
+        }
+        GameHeader header = {0, (uint8_t)game.result, 0, (uint16_t)game.white_elo, (uint16_t)game.black_elo, game.date};
+        if (!writer.append(header, &game.moves)) {
+            std::cerr << std::format("failed writing {}\n", store_path);
+            return 1;
+        }
+        imported++;
+    }
+
+    std::cout << std::format("imported {} games, skipped {} ({} bytes of pgn)\n", imported, skipped, text.str().size());
+    return 0;
+}
+
+int build_index(std::string store_path, std::string index_path, int threads) {
+    GameReader games(store_path);
+    if (!games.is_open()) {
+        std::cerr << std::format("can't open {}\n", store_path);
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    if (!build_position_index(&games, index_path, threads)) {
+        std::cerr << std::format("failed writing {}\n", index_path);
+        return 1;
+    }
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << std::format("indexed {} games in {} ms\n", games.game_count(), ms);
+    return 0;
+}
+
+int find_position(std::string store_path, std::string index_path, int argc, char **argv) {
+    GameReader games(store_path);
+    PositionIndex index(index_path);
+    if (!games.is_open() || !index.is_open()) {
+        std::cerr << "can't open the store or the index\n";
+        return 1;
+    }
+
+    // Play the given moves from the starting position
+    auto pieces = init_pieces(player.color);
+    int color = Piece::White;
+    for (int i = 0; i < argc; i++) {
+        Move move;
+        if (!move_from_string(argv[i], &move)) {
+            std::cerr << std::format("bad move {}\n", argv[i]);
+            return 1;
+        }
+        Position from = move_from(move);
+        auto legal_positions = get_legal_positions(&pieces, from.x, from.y);
+        if (piece_color(pieces[from.x][from.y]) != color || std::find(legal_positions.begin(), legal_positions.end(), move_to(move)) == legal_positions.end()) {
+            std::cerr << std::format("illegal move {}\n", argv[i]);
+            return 1;
+        }
+        move_piece(&pieces, from, move_to(move));
+        color = opposite_color(color);
+    }
+    uint64_t key = hash_position(&pieces, color);
+
+    auto start = std::chrono::steady_clock::now();
+    auto matches = index.find(key);
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+    for (auto &entry : matches) {
+        GameHeader header = games.header(entry.game_id);
+        std::cout << std::format("game {} ply {} result {} date {}\n", entry.game_id, entry.ply, (int)header.result, header.date);
+    }
+    std::cout << std::format("{} matches in {} us\n", matches.size(), us);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 4) {
+        usage();
+        return 1;
+    }
+    std::string command = argv[1];
+
+    if (command == "import") {
+        return import_pgn(argv[2], argv[3]);
+    } else if (command == "index") {
+        return build_index(argv[2], argv[3], argc > 4 ? std::atoi(argv[4]) : 0);
+    } else if (command == "find") {
+        return find_position(argv[2], argv[3], argc - 4, argv + 4);
+    }
+    usage();
+    return 1;
+}